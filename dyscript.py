@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+"""
+Compile a sound script to bytecode for DY::Script (see src/DYScript.h), as a
+C header to include in a sketch, e.g.:
+
+    ./dyscript.py show.dys -o show.h
+
+A script has one instruction per line, # starts a comment:
+
+    volume 20
+    repeat 3                  # Repeat 3 times, without a number: forever.
+      play 12                 # Play 00012.mp3.
+      wait end                # Wait until it stopped playing.
+      path flash /SONGS/X.MP3 # Play by device (usb, sd, flash) and path.
+      interlude sd 3
+      wait 1500               # Wait 1.5 seconds.
+    end
+
+Other instructions: play, pause, stop, previous, next, select N,
+device DEVICE, volume up, volume down, eq (normal, pop, rock, jazz, classic),
+mode (repeat, repeat-one, one-off, random, repeat-dir, random-dir,
+sequence-dir, sequence), cycles N, interlude-path DEVICE PATH,
+stop interlude, combination 01 02 .., end combination.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+VERSION = 1
+LOOPS = 4  # DY_SCRIPT_LOOPS
+FRAME_LEN = 48  # DY_SCRIPT_FRAME_LEN, the longest frame on AVR.
+END, FRAME, WAIT_END, WAIT, JUMP, LOOP = range(6)
+
+DEVICES = {"usb": 0x00, "sd": 0x01, "flash": 0x02}
+EQS = {"normal": 0, "pop": 1, "rock": 2, "jazz": 3, "classic": 4}
+MODES = {
+    "repeat": 0,
+    "repeat-one": 1,
+    "one-off": 2,
+    "random": 3,
+    "repeat-dir": 4,
+    "random-dir": 5,
+    "sequence-dir": 6,
+    "sequence": 7,
+}
+#: Commands without arguments.
+SIMPLE = {
+    "play": 0x02,
+    "pause": 0x03,
+    "stop": 0x04,
+    "previous": 0x05,
+    "next": 0x06,
+    "volume up": 0x14,
+    "volume down": 0x15,
+    "stop interlude": 0x10,
+    "end combination": 0x1c,
+}
+
+
+class ScriptError(Exception):
+    pass
+
+
+def frame(command, args=b""):
+    """Encode a frame the way DYPlayer sends it."""
+    data = bytes([0xAA, command, len(args)]) + bytes(args)
+    data += bytes([sum(data) & 0xFF])
+    if len(data) > FRAME_LEN:
+        sys.stderr.write("warning: %d byte frame won't fit on AVR\n" % len(data))
+    return bytes([FRAME, len(data)]) + data
+
+
+def number(text, limit=0xFFFF):
+    if not re.match(r"^\d+$", text) or int(text) > limit:
+        raise ScriptError("expected a number up to %d, got %r" % (limit, text))
+    return int(text)
+
+
+def choice(text, options):
+    if text.lower() not in options:
+        raise ScriptError("expected one of %s, got %r" % (", ".join(options), text))
+    return options[text.lower()]
+
+
+def path(text):
+    """Convert a path like DYPlayer::byPathCommand() does."""
+    converted = text[0]
+    for char in text[1:]:
+        if char == ".":
+            converted += "*"
+        elif char == "/":
+            converted += "*/"
+        else:
+            converted += char.upper()
+    return converted.encode("ascii")
+
+
+def instruction(words):
+    """Compile a line that is not a repeat or end."""
+    line = " ".join(words).lower()
+    if line in SIMPLE:
+        return frame(SIMPLE[line])
+    name, args = words[0].lower(), words[1:]
+    if name == "wait" and args == ["end"]:
+        return bytes([WAIT_END])
+    if len(args) == 1:
+        arg = args[0]
+        if name == "wait":
+            ms = number(arg)
+            return bytes([WAIT, ms >> 8, ms & 0xFF])
+        if name in ("play", "select", "cycles"):
+            n = number(arg)
+            command = {"play": 0x07, "select": 0x1F, "cycles": 0x19}[name]
+            return frame(command, [n >> 8, n & 0xFF])
+        if name == "volume":
+            return frame(0x13, [number(arg, 30)])
+        if name == "device":
+            return frame(0x0B, [choice(arg, DEVICES)])
+        if name == "eq":
+            return frame(0x1A, [choice(arg, EQS)])
+        if name == "mode":
+            return frame(0x18, [choice(arg, MODES)])
+    if len(args) == 2:
+        device = choice(args[0], DEVICES)
+        if name == "interlude":
+            n = number(args[1])
+            return frame(0x16, [device, n >> 8, n & 0xFF])
+        if name in ("path", "interlude-path"):
+            command = 0x08 if name == "path" else 0x17
+            return frame(command, bytes([device]) + path(args[1]))
+    if name == "combination" and args:
+        if not all(re.match(r"^\d\d$", arg) for arg in args):
+            raise ScriptError("combination takes names of 2 digits, e.g. 01")
+        return frame(0x1B, "".join(args).encode("ascii"))
+    raise ScriptError("unknown instruction %r" % " ".join(words))
+
+
+def compile_script(source):
+    """Compile the text of a script to bytecode."""
+    code = bytearray([VERSION])
+    # Open repeats: (line number, position of the body, times).
+    repeats = []
+    for lineno, line in enumerate(source.splitlines(), 1):
+        words = line.split("#", 1)[0].split()
+        if not words:
+            continue
+        try:
+            if words[0].lower() == "repeat" and len(words) <= 2:
+                times = 0  # Forever.
+                if len(words) == 2:
+                    times = number(words[1], 255)
+                    if times == 0:
+                        raise ScriptError("repeat 0 times, leave out the "
+                                          "number to repeat forever")
+                repeats.append((lineno, len(code), times))
+            elif words == ["end"]:
+                if not repeats:
+                    raise ScriptError("end without repeat")
+                _, start, times = repeats.pop()
+                if start == len(code):
+                    raise ScriptError("empty repeat")
+                if times == 0:
+                    code += bytes([JUMP, start >> 8, start & 0xFF])
+                else:
+                    counter = sum(1 for r in repeats if r[2] > 0)
+                    if counter >= LOOPS:
+                        raise ScriptError("repeats nested too deep")
+                    code += bytes([LOOP, counter, times, start >> 8, start & 0xFF])
+            else:
+                code += instruction(words)
+        except ScriptError as error:
+            raise ScriptError("line %d: %s" % (lineno, error))
+    if repeats:
+        raise ScriptError("line %d: repeat without end" % repeats[-1][0])
+    code.append(END)
+    if len(code) > 0xFFFF:
+        raise ScriptError("script too long")
+    return bytes(code)
+
+
+def header(code, name, source):
+    lines = [
+        "// Compiled by dyscript.py from %s, don't edit." % source,
+        "#include \"DYScript.h\"",
+        "",
+        "const uint8_t %s[%d] DY_PROGMEM = {" % (name, len(code)),
+    ]
+    for i in range(0, len(code), 12):
+        lines.append("    " + ", ".join("0x%02x" % b for b in code[i:i + 12]) + ",")
+    lines.append("};")
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__.split("\n\n")[0],
+        formatter_class=argparse.RawDescriptionHelpFormatter,
+        epilog="\n\n".join(__doc__.split("\n\n")[2:]),
+    )
+    parser.add_argument("script", help="script to compile")
+    parser.add_argument("-o", "--output", help="header to write, default: stdout")
+    parser.add_argument("-n", "--name",
+                        help="name of the array, default: the script's file name")
+    parser.add_argument("-b", "--binary", action="store_true",
+                        help="write the bytecode as is instead of a header")
+    args = parser.parse_args()
+
+    with open(args.script) as f:
+        source = f.read()
+    try:
+        code = compile_script(source)
+    except ScriptError as error:
+        sys.stderr.write("%s: %s\n" % (args.script, error))
+        return 1
+    name = args.name or re.sub(r"\W", "_", os.path.splitext(
+        os.path.basename(args.script))[0])
+    if args.binary:
+        output = code
+    else:
+        output = header(code, name, os.path.basename(args.script)).encode()
+    if args.output:
+        with open(args.output, "wb") as f:
+            f.write(output)
+    else:
+        sys.stdout.buffer.write(output)
+    sys.stderr.write("%s: %d bytes\n" % (args.script, len(code)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
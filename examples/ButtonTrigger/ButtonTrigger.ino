@@ -0,0 +1,53 @@
+#include <Arduino.h>
+#include "DYPlayerArduino.h"
+#include "DYTrigger.h"
+#include <SoftwareSerial.h>
+
+// Initialise on software serial port, so Serial can be used for printing.
+SoftwareSerial SoftSerial(10, 11);
+DY::Player player(&SoftSerial);
+DY::TriggerQueue triggers;
+
+// Connect a button between pin 2 and GND.
+const uint8_t buttonPin = 2;
+// Time of each press in the queue, a ring in step with the queue: the n-th
+// press pushed is the n-th sound popped.
+volatile uint32_t pressedAt[DY_TRIGGER_QUEUE_LEN];
+volatile uint8_t pushed = 0;
+uint8_t popped = 0;
+
+void onButton() {
+  uint32_t now = micros();
+  if (triggers.push(1))
+    pressedAt[pushed++ & (DY_TRIGGER_QUEUE_LEN - 1)] = now;
+}
+
+void setup() {
+  player.begin();
+  Serial.begin(9600);
+  player.setVolume(15); // 50% Volume
+  pinMode(buttonPin, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(buttonPin), onButton, FALLING);
+}
+
+void loop() {
+  uint16_t number;
+  while (true) {
+    // Take the sound and the time of its press together, once it's popped
+    // a new press may reuse its slot.
+    noInterrupts();
+    bool taken = triggers.pop(&number);
+    uint32_t pressed = pressedAt[popped & (DY_TRIGGER_QUEUE_LEN - 1)];
+    interrupts();
+    if (!taken)
+      break;
+    popped++;
+    // The first byte is written right after this, so this is the latency from
+    // button to first TX byte, it mostly depends on the rest of your loop.
+    uint32_t latency = micros() - pressed;
+    player.playSpecified(number);
+    Serial.print("Button to first TX byte: ");
+    Serial.print(latency);
+    Serial.println("us");
+  }
+}
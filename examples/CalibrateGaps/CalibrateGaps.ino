@@ -0,0 +1,60 @@
+#include <Arduino.h>
+#include "DYPlayerArduino.h"
+#include <SoftwareSerial.h>
+
+// Initialise on software serial port, so Serial can be used for printing.
+SoftwareSerial SoftSerial(10, 11);
+DY::Player player(&SoftSerial);
+
+const char *names[] = {"Query", "Control", "Play", "Path", "Device", "Setting"};
+const uint8_t commands = 40;
+
+// Send a mix of commands that are often dropped when sent too soon.
+uint32_t sendMix(uint16_t padding) {
+  DY::device_t device = player.getPlayingDevice();
+  uint32_t start = millis();
+  for (uint8_t i = 0; i < commands / 4; i++) {
+    player.setPlayingDevice(device);
+    delay(padding);
+    player.select(1);
+    delay(padding);
+    player.setVolume(15);
+    delay(padding);
+    player.stop();
+    delay(padding);
+  }
+  return millis() - start;
+}
+
+void printRate(const char *label, uint32_t ms) {
+  Serial.print(label);
+  Serial.print(commands * 1000.0 / ms);
+  Serial.println(" commands/s");
+}
+
+void setup() {
+  player.begin();
+  Serial.begin(9600);
+
+  // Fixed padding, the worst-case gap after every command.
+  printRate("Fixed padding (500ms): ", sendMix(500));
+
+  uint32_t start = millis();
+  player.calibrateGaps();
+  Serial.print("Calibrated in ");
+  Serial.print(millis() - start);
+  Serial.println("ms:");
+  for (uint8_t i = 0; i < 6; i++) {
+    Serial.print("  ");
+    Serial.print(names[i]);
+    Serial.print(": ");
+    Serial.print(player.getGap((DY::gap_t)i));
+    Serial.println("ms");
+  }
+  printRate("Calibrated gaps: ", sendMix(0));
+}
+
+void loop() {
+  /* Nothing to do.. */
+  delay(5000);
+}
@@ -0,0 +1,49 @@
+#include <Arduino.h>
+#include "DYPlayerArduino.h"
+#include "DYIndex.h"
+#include <SoftwareSerial.h>
+
+// Initialise on software serial port, so Serial can be used for printing.
+SoftwareSerial SoftSerial(10, 11);
+DY::Player player(&SoftSerial);
+// Keep the index in EEPROM, starting at address 0.
+DY::EepromStorage storage(0);
+DY::ContentIndex contentIndex(&player, &storage);
+
+void setup() {
+  player.begin();
+  Serial.begin(9600);
+
+  // Measure how long it takes before the content is known. The first boot (or
+  // after changing the sound files) is a cold boot, the index is built. After
+  // that the stored index is used, check it by power cycling the board.
+  uint32_t start = millis();
+  bool warm = contentIndex.begin();
+  uint32_t elapsed = millis() - start;
+  Serial.print(warm ? "Warm" : "Cold");
+  Serial.print(" boot, index ready in ");
+  Serial.print(elapsed);
+  Serial.println("ms");
+
+  for (uint8_t d = 0; d < 3; d++) {
+    DY::device_t device = (DY::device_t)d;
+    Serial.print("Device ");
+    Serial.print(d);
+    Serial.print(": ");
+    Serial.print(contentIndex.getSoundCount(device));
+    Serial.print(" sounds in ");
+    Serial.print(contentIndex.getDirCount(device));
+    Serial.println(" directories.");
+    for (uint8_t i = 0; i < contentIndex.getDirCount(device); i++) {
+      Serial.print("  First: ");
+      Serial.print(contentIndex.getFirstInDir(device, i));
+      Serial.print(", count: ");
+      Serial.println(contentIndex.getSoundCountDir(device, i));
+    }
+  }
+}
+
+void loop() {
+  /* Nothing to do.. */
+  delay(5000);
+}
@@ -0,0 +1,63 @@
+#include <Arduino.h>
+#include "DYPlayerArduino.h"
+#include <SoftwareSerial.h>
+
+// Initialise on software serial port, so Serial can be used for printing.
+SoftwareSerial SoftSerial(10, 11);
+DY::Player player(&SoftSerial);
+
+uint16_t sound = 1;
+uint32_t worstLoop = 0;
+uint32_t lastLoop = 0;
+uint32_t lastReport = 0;
+uint32_t lastBlink = 0;
+
+void setup() {
+  player.begin();
+  // Never spend more than 200us reading from the module.
+  player.setReadBudget(200);
+  Serial.begin(9600);
+  pinMode(LED_BUILTIN, OUTPUT);
+  player.setVolume(15); // 50% Volume
+  player.playSpecified(sound);
+  player.beginQuery(DY::Query::PlayState);
+}
+
+void loop() {
+  // Keeps blinking while the module is being queried.
+  if (millis() - lastBlink >= 100) {
+    lastBlink = millis();
+    digitalWrite(LED_BUILTIN, !digitalRead(LED_BUILTIN));
+  }
+
+  // Play the next sound when the current one stopped.
+  uint16_t state;
+  switch (player.pollQuery(&state)) {
+    case DY::QueryState::Pending:
+      break;
+    case DY::QueryState::Done:
+      if ((DY::play_state_t)state == DY::PlayState::Stopped) {
+        player.playSpecified(++sound);
+      }
+      // fall-through
+    case DY::QueryState::Fail:
+      player.beginQuery(DY::Query::PlayState);
+      break;
+  }
+
+  // Measure the worst-case loop time, excluding the printing below.
+  uint32_t now = micros();
+  if (lastLoop != 0 && now - lastLoop > worstLoop) {
+    worstLoop = now - lastLoop;
+  }
+  if (millis() - lastReport >= 5000) {
+    lastReport = millis();
+    Serial.print("Worst-case loop time: ");
+    Serial.print(worstLoop);
+    Serial.println("us");
+    worstLoop = 0;
+    lastLoop = 0;
+    return;
+  }
+  lastLoop = micros();
+}
@@ -0,0 +1,35 @@
+/**
+ * Run a sound script (show.dys, compiled to show.h by dyscript.py) without
+ * blocking, the LED keeps blinking while the show plays.
+ */
+#include <Arduino.h>
+#include "DYPlayerArduino.h"
+#include "DYScript.h"
+#include <SoftwareSerial.h>
+#include "show.h"
+
+// Initialise on software serial port, so Serial can be used for printing.
+SoftwareSerial SoftSerial(10, 11);
+DY::Player player(&SoftSerial);
+DY::Script script(&player);
+
+uint32_t lastBlink = 0;
+
+void setup() {
+  player.begin();
+  // Never spend more than 200us reading from the module.
+  player.setReadBudget(200);
+  Serial.begin(9600);
+  pinMode(LED_BUILTIN, OUTPUT);
+  if (!script.begin(show, sizeof(show))) {
+    Serial.println("Invalid script, compile it again.");
+  }
+}
+
+void loop() {
+  if (millis() - lastBlink >= 100) {
+    lastBlink = millis();
+    digitalWrite(LED_BUILTIN, !digitalRead(LED_BUILTIN));
+  }
+  script.update();
+}
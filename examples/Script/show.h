@@ -0,0 +1,12 @@
+// Compiled by dyscript.py from show.dys, don't edit.
+#include "DYScript.h"
+
+const uint8_t show[75] DY_PROGMEM = {
+    0x01, 0x01, 0x05, 0xaa, 0x13, 0x01, 0x14, 0xd2, 0x01, 0x06, 0xaa, 0x07,
+    0x02, 0x00, 0x0c, 0xbf, 0x02, 0x01, 0x05, 0xaa, 0x13, 0x01, 0x19, 0xd7,
+    0x01, 0x19, 0xaa, 0x08, 0x15, 0x02, 0x2f, 0x53, 0x4f, 0x55, 0x4e, 0x44,
+    0x53, 0x2a, 0x2f, 0x46, 0x41, 0x4e, 0x46, 0x41, 0x52, 0x45, 0x2a, 0x4d,
+    0x50, 0x33, 0x1a, 0x03, 0x07, 0xd0, 0x01, 0x07, 0xaa, 0x16, 0x03, 0x02,
+    0x00, 0x03, 0xc8, 0x02, 0x01, 0x05, 0xaa, 0x13, 0x01, 0x14, 0xd2, 0x04,
+    0x00, 0x08, 0x00,
+};
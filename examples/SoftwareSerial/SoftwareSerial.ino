@@ -8,6 +8,9 @@ DY::Player player(&SoftSerial);
 
 void setup() {
   player.begin();
+  // Only listen while a response is expected, saves CPU time and allows
+  // other SoftwareSerial ports to listen meanwhile.
+  player.setListenOnDemand(true);
   // Also initiate the hardware serial port so we can use it for debug printing
   // to the console..
   Serial.begin(9600);
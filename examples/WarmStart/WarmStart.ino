@@ -0,0 +1,43 @@
+#include <Arduino.h>
+#include "DYPlayerArduino.h"
+#include "DYProfile.h"
+#include <SoftwareSerial.h>
+
+// Initialise on software serial port, so Serial can be used for printing.
+SoftwareSerial SoftSerial(10, 11);
+DY::Player player(&SoftSerial);
+// Keep the profile in EEPROM, starting at address 0.
+DY::EepromStorage storage(0);
+DY::Profile profile(&player, &storage);
+
+void setup() {
+  player.begin();
+  Serial.begin(9600);
+
+  if (!profile.load()) {
+    // Nothing stored yet, set the settings you want and keep them.
+    profile.desired.volume = 15; // 50% Volume
+    profile.desired.cycleMode = DY::PlayMode::Repeat; // Play all and repeat.
+    profile.desired.device = DY::Device::Flash;
+    profile.save();
+  }
+
+  // Track these figures to see the boot latency across firmware releases.
+  // The module is powered with the board here, if it can keep its settings
+  // while the board resets (e.g. a watchdog reset), use restore(false).
+  DY::restore_result_t result = profile.restore();
+  Serial.print("Ready in ");
+  Serial.print(result.timeMs);
+  Serial.print("ms, ");
+  Serial.print(result.commands);
+  Serial.print(" commands, ");
+  Serial.print(result.bytes);
+  Serial.print(" bytes sent, ");
+  Serial.println(result.verified ? "device confirmed." : "device not confirmed!");
+  player.play();
+}
+
+void loop() {
+  /* Nothing to do.. */
+  delay(5000);
+}
@@ -0,0 +1,170 @@
+/**
+ * Program used by footprint.py to measure the flash and RAM used by the
+ * library in each build profile. It calls every command that the profile
+ * leaves in, so the linker can't drop any of them. Not meant to be run.
+ *
+ * The components on top of the player are only measured when their
+ * `DY_FOOTPRINT_*` define is set, so their cost is the difference with the
+ * `full` profile. `DY_FOOTPRINT_SOFTWARE_SERIAL` uses a `SoftwareSerial` port
+ * on boards that have it.
+ */
+#ifdef DY_FOOTPRINT
+// Arduino-ESP32 defines ESP_PLATFORM too, it uses the Arduino HAL.
+#if defined(ESP_PLATFORM) && !defined(ARDUINO)
+#include "DYPlayerESP32.h"
+
+DY::Player player(UART_NUM_2, 18, 19);
+#if defined(DY_FOOTPRINT_CONTENT_INDEX) || defined(DY_FOOTPRINT_PROFILE)
+DY::NvsStorage storage("footprint");
+#endif
+#else
+#include <Arduino.h>
+#include "DYPlayerArduino.h"
+
+#if defined(DY_FOOTPRINT_SOFTWARE_SERIAL) && defined(HAS_SOFTWARE_SERIAL)
+SoftwareSerial softSerial(10, 11);
+DY::Player player(&softSerial);
+#else
+DY::Player player;
+#endif
+#if defined(DY_FOOTPRINT_CONTENT_INDEX) || defined(DY_FOOTPRINT_PROFILE)
+DY::EepromStorage storage(0);
+#endif
+#endif
+
+#ifdef DY_FOOTPRINT_TRIGGER_QUEUE
+#include "DYTrigger.h"
+
+DY::TriggerQueue triggers;
+#endif
+#ifdef DY_FOOTPRINT_SCRIPT
+#include "DYScript.h"
+
+// Version, volume 20, end.
+const uint8_t code[] DY_PROGMEM = {0x01, 0x01, 0x05, 0xaa, 0x13,
+                                   0x01, 0x14, 0xd2, 0x00};
+DY::Script script(&player);
+#endif
+#ifdef DY_FOOTPRINT_CONTENT_INDEX
+#include "DYIndex.h"
+
+DY::ContentIndex contentIndex(&player, &storage);
+#endif
+#ifdef DY_FOOTPRINT_PROFILE
+#include "DYProfile.h"
+
+DY::Profile profile(&player, &storage);
+#endif
+#ifdef DY_FOOTPRINT_LINK_HEALTH
+#include "DYLink.h"
+
+DY::LinkHealth linkHealth(&player);
+#endif
+
+void run()
+{
+  player.play();
+  player.pause();
+  player.stop();
+  player.previous();
+  player.next();
+  player.playSpecified(1);
+  player.setPlayingDevice(DY::Device::Sd);
+  player.previousDir(DY::PreviousDir::FirstSound);
+  player.setVolume(15);
+  player.volumeIncrease();
+  player.volumeDecrease();
+  player.setCycleMode(DY::PlayMode::Repeat);
+  player.setCycleTimes(2);
+  player.setEq(DY::Eq::Normal);
+  player.select(1);
+  uint16_t value;
+  player.query(DY::Query::SoundCount, &value);
+  player.beginQuery(DY::Query::PlayState);
+  player.pollQuery(&value);
+  if (player.checkPlayState() == DY::PlayState::Fail ||
+      player.getPlayingDevice() == DY::Device::Fail)
+    return;
+  value += player.getSoundCount() + player.getPlayingSound() +
+           player.getFirstInDir() + player.getSoundCountDir();
+#ifndef DY_NO_PATHS
+  char path[] = "/00001.MP3";
+  player.playSpecifiedDevicePath(DY::Device::Flash, path);
+#endif
+#ifndef DY_NO_INTERLUDE
+  player.interludeSpecified(DY::Device::Flash, value);
+#ifndef DY_NO_PATHS
+  player.interludeSpecifiedDevicePath(DY::Device::Flash, path);
+#endif
+  player.stopInterlude();
+#endif
+#ifndef DY_NO_COMBINATION_PLAY
+  char first[] = "01";
+  char *sounds[] = {first};
+  player.combinationPlay(sounds, 1);
+  player.endCombinationPlay();
+#endif
+#ifndef DY_NO_BATCH
+  uint8_t buffer[16];
+  player.beginBatch(buffer, sizeof(buffer));
+  player.setVolume(20);
+  player.endBatch();
+#endif
+#ifndef DY_NO_GAPS
+  player.setGap(DY::Gap::Device, player.getGap(DY::Gap::Play));
+  player.calibrateGaps();
+#endif
+#ifdef DY_FOOTPRINT_TRIGGER_QUEUE
+  triggers.push(value);
+  triggers.drain(&player);
+#endif
+#ifdef DY_FOOTPRINT_SCRIPT
+  if (!script.isRunning())
+    script.begin(code, sizeof(code));
+  script.update();
+#endif
+#ifdef DY_FOOTPRINT_CONTENT_INDEX
+  contentIndex.begin();
+  value += contentIndex.getSoundCount(DY::Device::Sd) +
+           contentIndex.getDirCount(DY::Device::Sd) +
+           contentIndex.getFirstInDir(DY::Device::Sd, 0) +
+           contentIndex.getSoundCountDir(DY::Device::Sd, 0);
+  player.playSpecified(value);
+#endif
+#ifdef DY_FOOTPRINT_PROFILE
+  profile.load();
+  profile.restore();
+  profile.desired.volume = 20;
+  profile.save();
+#endif
+#ifdef DY_FOOTPRINT_LINK_HEALTH
+  linkHealth.update();
+  if (linkHealth.isUp() && linkHealth.checkPlayState() != DY::PlayState::Fail &&
+      linkHealth.getPlayingDevice() != DY::Device::Fail &&
+      linkHealth.query(DY::Query::SoundCount, &value))
+    linkHealth.setVolume(value);
+  linkHealth.setEq(DY::Eq::Normal);
+  linkHealth.setCycleMode(DY::PlayMode::Repeat);
+  linkHealth.setCycleTimes(2);
+  linkHealth.setPlayingDevice(DY::Device::Sd);
+#endif
+}
+
+#if defined(ESP_PLATFORM) && !defined(ARDUINO)
+extern "C" void app_main(void)
+{
+  while (true)
+    run();
+}
+#else
+void setup()
+{
+  player.begin();
+}
+
+void loop()
+{
+  run();
+}
+#endif
+#endif
@@ -0,0 +1,77 @@
+/*
+  Compare fixed padding after every command with gaps measured by
+  calibrateGaps(), on a simulated module that drops commands arriving too soon
+  after the previous one. Sends the same mix of commands as
+  CalibrateGaps.ino and counts the commands the module dropped.
+  Build with e.g.:
+    g++ -std=c++11 -Isrc examples/host/CalibrateGaps.cpp src/DYPlayer.cpp \
+      src/DYSimulator.cpp -o calibrategaps
+  Run with the padding in milliseconds (optional, default 500):
+    ./calibrategaps 300
+*/
+#if defined(__unix__) && !defined(ARDUINO) && !defined(ESP_PLATFORM)
+#include <stdio.h>
+#include <stdlib.h>
+#include "DYSimulator.h"
+
+const char *names[] = {"Query", "Control", "Play", "Path", "Device", "Setting"};
+const uint8_t commands = 40;
+
+// Send a mix of commands that are often dropped when sent too soon.
+uint32_t sendMix(DY::SimPlayer *player, uint16_t padding)
+{
+  DY::device_t device = player->getPlayingDevice();
+  uint32_t start = player->timeMs();
+  for (uint8_t i = 0; i < commands / 4; i++)
+  {
+    player->setPlayingDevice(device);
+    player->delayMs(padding);
+    player->select(1);
+    player->delayMs(padding);
+    player->setVolume(15);
+    player->delayMs(padding);
+    player->stop();
+    player->delayMs(padding);
+  }
+  // Writes return right away, let the last command arrive.
+  player->delayMs(10);
+  return player->timeMs() - start;
+}
+
+void printRun(const char *label, uint32_t ms, uint32_t dropped)
+{
+  printf("%-16s %6ums, %5.1f commands/s, %u dropped\n", label, ms,
+         commands * 1000.0 / ms, dropped);
+}
+
+int main(int argc, char **argv)
+{
+  uint16_t padding = argc > 1 ? atoi(argv[1]) : 500;
+  DY::Simulation sim;
+  DY::SimModule module(&sim);
+  // Rough figures, measure your modules with calibrateGaps().
+  module.config.busyUs[(uint8_t)DY::Gap::Control] = 20000;
+  module.config.busyUs[(uint8_t)DY::Gap::Play] = 40000;
+  module.config.busyUs[(uint8_t)DY::Gap::Device] = 300000;
+  module.config.busyUs[(uint8_t)DY::Gap::Setting] = 20000;
+  DY::SimPlayer player(&sim, &module);
+
+  char label[32];
+  snprintf(label, sizeof(label), "Padding %ums:", padding);
+  uint32_t ms = sendMix(&player, padding);
+  printRun(label, ms, module.stats.dropped);
+
+  uint32_t start = player.timeMs();
+  player.calibrateGaps();
+  printf("Calibrated in %ums:\n", player.timeMs() - start);
+  for (uint8_t i = 0; i < 6; i++)
+  {
+    printf("  %-8s %4ums (module: %ums)\n", names[i],
+           player.getGap((DY::gap_t)i), module.config.busyUs[i] / 1000);
+  }
+  uint32_t dropped = module.stats.dropped;
+  ms = sendMix(&player, 0);
+  printRun("Calibrated gaps:", ms, module.stats.dropped - dropped);
+  return 0;
+}
+#endif
@@ -0,0 +1,101 @@
+/*
+  Contention benchmark of the thread-safe player, 1 to 64 threads queue
+  commands to a single module. The module is simulated, it answers every
+  query right away, so this measures the library, not the UART. Each thread
+  also sets its own volume and queries it back in one job: if commands of
+  different threads were interleaved, the answer would be another thread's
+  volume, or no answer at all, and is counted as wrong.
+  Build with e.g.:
+    g++ -std=c++20 -O2 -Isrc examples/host/Contention.cpp src/DYPlayer.cpp \
+      src/DYThreaded.cpp -o contention -pthread
+*/
+#if defined(__unix__) && !defined(ARDUINO) && !defined(ESP_PLATFORM)
+#include <stdio.h>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+#include "DYThreaded.h"
+
+// Answers the sound count query with the last volume that was set, and
+// nothing else: an answer depends on what was written right before it.
+class SimulatedPlayer : public DY::DYPlayer
+{
+public:
+  void serialWrite(uint8_t *buffer, uint8_t len)
+  {
+    // A command is written as the frame, then its CRC.
+    if (len < 3 || buffer[0] != 0xaa)
+      return;
+    last = buffer[1];
+    if (last == 0x13)
+      volume = buffer[3];
+  }
+  bool serialRead(uint8_t *buffer, uint8_t len)
+  {
+    if (last != 0x0c)
+      return false;
+    uint8_t response[6] = {0xaa, 0x0c, 0x02, 0x00, volume, 0};
+    response[5] = 0xaa + 0x0c + 0x02 + volume;
+    for (uint8_t i = 0; i < len && i < 6; i++)
+      buffer[i] = response[i];
+    return true;
+  }
+
+private:
+  uint8_t last = 0;
+  uint8_t volume = 0;
+};
+
+int main()
+{
+  const int perThread = 20000;
+  printf("threads, commands/s, mean enqueue (ns), wrong answers\n");
+  for (int threads = 1; threads <= 64; threads *= 2)
+  {
+    SimulatedPlayer simulated;
+    DY::ThreadedPlayer player(&simulated);
+    std::vector<std::thread> producers;
+    std::atomic<int64_t> enqueueNs{0};
+    std::atomic<int> wrong{0};
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++)
+    {
+      // Volumes 1 to 30, one per thread.
+      uint8_t volume = t % 30 + 1;
+      producers.emplace_back([&, volume]()
+                             {
+        std::vector<std::future<uint16_t>> counts;
+        counts.reserve(perThread / 2);
+        int64_t ns = 0;
+        for (int i = 0; i < perThread; i++)
+        {
+          auto before = std::chrono::steady_clock::now();
+          if (i % 2)
+            counts.push_back(player.submit([volume](DY::DYPlayer *p)
+                                           {
+              p->setVolume(volume);
+              return p->getSoundCount(); }));
+          else
+            player.setVolume(0);
+          ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - before)
+                    .count();
+        }
+        enqueueNs += ns;
+        for (auto &count : counts)
+          if (count.get() != volume)
+            wrong++; });
+    }
+    for (auto &producer : producers)
+      producer.join();
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    int64_t commands = (int64_t)threads * perThread;
+    printf("%d, %.0f, %.0f, %d\n", threads, commands / seconds,
+           (double)enqueueNs / commands, wrong.load());
+  }
+  return 0;
+}
+#endif
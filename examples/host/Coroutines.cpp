@@ -0,0 +1,101 @@
+/*
+  Drive several modules from one thread with coroutines, on Linux.
+  Build with e.g.:
+    g++ -std=c++20 -Isrc examples/host/Coroutines.cpp src/DYPlayer.cpp \
+      src/DYPlayerPosix.cpp src/DYCoroutine.cpp src/DYSimulator.cpp \
+      -o coroutines
+  Run with the serial ports the modules are connected to:
+    ./coroutines /dev/ttyUSB0 /dev/ttyUSB1
+  Or without, to drive 16 simulated modules in virtual time:
+    ./coroutines
+*/
+#if defined(__unix__) && !defined(ARDUINO) && !defined(ESP_PLATFORM)
+#include <stdio.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "DYPlayerPosix.h"
+#include "DYCoroutine.h"
+#include "DYSimulator.h"
+
+// Simulated modules when no serial ports are given.
+#define SIM_MODULES 16
+
+// Runs the coroutines in the virtual time of a simulation.
+class SimExecutor : public DY::Executor
+{
+public:
+  DY::Simulation *sim;
+  SimExecutor(DY::Simulation *sim) : sim(sim) {}
+  uint32_t timeMs() { return sim->now / 1000; }
+  void idle() { sim->run(sim->now + 1000); }
+};
+
+// Play the first 3 sounds on a module, one after the other.
+DY::Task<void> playFirstSounds(DY::AsyncPlayer &player, const char *name)
+{
+  for (uint16_t sound = 1; sound <= 3; sound++)
+  {
+    player.player->playSpecified(sound);
+    // Give the module a moment to start playing.
+    co_await player.sleep(200);
+    if (!co_await player.waitUntilStopped(60000))
+    {
+      printf("%s: sound %u didn't stop, giving up.\n", name, sound);
+      co_return;
+    }
+    printf("%s: played sound %u.\n", name, sound);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  DY::Simulation sim;
+  SimExecutor simExecutor(&sim);
+  DY::Executor realExecutor;
+  DY::Executor &executor = argc > 1 ? realExecutor : simExecutor;
+  std::vector<std::unique_ptr<DY::DYPlayer>> players;
+  std::vector<std::unique_ptr<DY::SimModule>> modules;
+  std::vector<std::unique_ptr<DY::AsyncPlayer>> asyncPlayers;
+  std::vector<std::string> names;
+  int count = argc > 1 ? argc - 1 : SIM_MODULES;
+  for (int i = 0; i < count; i++)
+  {
+    if (argc > 1)
+    {
+      DY::Player *player = new DY::Player(argv[i + 1]);
+      // Don't wait for responses, the executor polls for them.
+      player->setReadTimeout(0);
+      players.emplace_back(player);
+      names.push_back(argv[i + 1]);
+    }
+    else
+    {
+      modules.emplace_back(new DY::SimModule(&sim, i + 1));
+      // Tracks of 2 to 5 seconds, different on every module.
+      modules.back()->tracks = {2000u + i * 100, 3000u + i * 100,
+                                4000u + i * 100};
+      DY::SimPlayer *player = new DY::SimPlayer(&sim, modules.back().get());
+      player->setReadTimeout(0);
+      players.emplace_back(player);
+      names.push_back("Module " + std::to_string(i + 1));
+    }
+  }
+  for (int i = 0; i < count; i++)
+  {
+    asyncPlayers.emplace_back(
+        new DY::AsyncPlayer(players[i].get(), &executor));
+    executor.spawn(playFirstSounds(*asyncPlayers.back(), names[i].c_str()));
+  }
+  executor.run();
+
+  // Frames are reused from the pool, in a steady state nothing is allocated.
+  DY::frame_stats_t stats = DY::FramePool::stats;
+  printf("Coroutine frames: %u allocated, %u reused, %u from the heap, "
+         "peak %u.\n",
+         stats.allocations, stats.reused, stats.heap, stats.peak);
+  if (argc == 1)
+    printf("Simulated %u modules for %.1fs.\n", count, sim.now / 1e6);
+  return 0;
+}
+#endif
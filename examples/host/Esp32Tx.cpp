@@ -0,0 +1,158 @@
+/*
+  Model of the ESP-IDF UART transmit path, to compare the time callers spend
+  blocked in DY::Player::serialWrite() on ESP32 with and without checking
+  txFree() first. It compiles the real DYPlayerESP32.cpp against the model in
+  idf/: a 128 byte FIFO, a 256 byte TX ring buffer filled by
+  uart_write_bytes() (which waits while it's full) and a wire that takes
+  1042us per byte at 9600 baud. Time is virtual, only waiting costs time,
+  copying bytes is free, so it shows the waiting, not the CPU time. It checks
+  the estimate of txFree() against this model of the driver, not against the
+  driver itself.
+  Build with e.g.:
+    g++ -std=c++11 -DESP_PLATFORM -Iexamples/host/idf -Isrc \
+      examples/host/Esp32Tx.cpp src/DYPlayerESP32.cpp src/DYPlayer.cpp \
+      -o esp32tx
+  Run with the amount of commands and the time between them in
+  microseconds (optional):
+    ./esp32tx 300 2000
+*/
+#if defined(__unix__) && defined(ESP_PLATFORM) && !defined(ARDUINO)
+#include <stdio.h>
+#include <stdlib.h>
+#include <deque>
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "DYPlayerESP32.h"
+
+#define FIFO_SIZE 128
+#define RING_SIZE 256
+#define BYTE_US 1042
+
+static int64_t now = 0;
+// When the byte being shifted out is done, -1 while the wire is idle.
+static int64_t byteDone = -1;
+static std::deque<char> fifo;
+static std::deque<char> ring;
+
+// Let time pass: the driver's interrupt refills the FIFO from the ring
+// buffer and the FIFO shifts out a byte per BYTE_US.
+static void advance(int64_t until)
+{
+  while (true)
+  {
+    while (fifo.size() < FIFO_SIZE && !ring.empty())
+    {
+      fifo.push_back(ring.front());
+      ring.pop_front();
+    }
+    if (byteDone < 0)
+    {
+      if (fifo.empty())
+      {
+        now = until;
+        return;
+      }
+      byteDone = now + BYTE_US;
+    }
+    if (byteDone > until)
+    {
+      now = until;
+      return;
+    }
+    now = byteDone;
+    byteDone = -1;
+    fifo.pop_front();
+  }
+}
+
+int64_t esp_timer_get_time()
+{
+  return now;
+}
+
+int uart_write_bytes(uart_port_t, const char *src, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    // Blocks until the interrupt made room.
+    while (ring.size() >= RING_SIZE)
+      advance(now + BYTE_US);
+    ring.push_back(src[i]);
+  }
+  advance(now);
+  return size;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t, TickType_t ticks)
+{
+  int64_t until = now + (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+  while ((!fifo.empty() || !ring.empty()) && now < until)
+    advance(now + BYTE_US < until ? now + BYTE_US : until);
+  return fifo.empty() && ring.empty() ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+esp_err_t uart_param_config(uart_port_t, const uart_config_t *) { return 0; }
+esp_err_t uart_set_pin(uart_port_t, int, int, int, int) { return 0; }
+esp_err_t uart_driver_install(uart_port_t, int, int, int, QueueHandle_t *,
+                              int)
+{
+  return 0;
+}
+esp_err_t uart_get_buffered_data_len(uart_port_t, size_t *size)
+{
+  *size = 0;
+  return 0;
+}
+int uart_read_bytes(uart_port_t, void *, uint32_t, TickType_t) { return 0; }
+esp_err_t uart_flush_input(uart_port_t) { return 0; }
+void vTaskDelay(uint32_t ticks)
+{
+  advance(now + (int64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+int nvs_open(const char *, int, nvs_handle_t *) { return 1; }
+int nvs_get_blob(nvs_handle_t, const char *, void *, size_t *) { return 1; }
+int nvs_set_blob(nvs_handle_t, const char *, const void *, size_t) { return 1; }
+int nvs_commit(nvs_handle_t) { return 1; }
+void nvs_close(nvs_handle_t) {}
+
+// Offer a volume command every interval, check for room first if asked.
+static void run(const char *label, uint32_t commands, uint32_t interval,
+                bool checkFree)
+{
+  now = 0;
+  byteDone = -1;
+  fifo.clear();
+  ring.clear();
+  DY::Player player(UART_NUM_2, 18, 19);
+  uint32_t sent = 0;
+  uint32_t deferred = 0;
+  for (uint32_t i = 0; i < commands; i++)
+  {
+    advance((int64_t)i * interval > now ? (int64_t)i * interval : now);
+    if (checkFree && player.txFree() < 5)
+    {
+      deferred++; // E.g. send it on a later pass through the loop.
+      continue;
+    }
+    player.setVolume(i % 30);
+    sent++;
+  }
+  player.waitTxDone(60000);
+  printf("%-20s %4u sent, %4u deferred, blocked per command: %6.0fus on "
+         "average, %6uus at most\n",
+         label, sent, deferred, (double)player.txStats.blockedUs / sent,
+         player.txStats.maxBlockedUs);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t commands = argc > 1 ? atoi(argv[1]) : 300;
+  uint32_t interval = argc > 2 ? atoi(argv[2]) : 2000;
+  printf("%u commands of 5 bytes, one every %uus, the wire takes %uus each\n",
+         commands, interval, 5 * BYTE_US);
+  run("Writing right away:", commands, interval, false);
+  run("Checking txFree():", commands, interval, true);
+  return 0;
+}
+#endif
@@ -0,0 +1,165 @@
+/*
+  Check DY::LinkHealth against a simulated module that stops answering: the
+  link goes down after DY_LINK_FAILURES failed queries, queries fail right
+  away, settings aren't sent, probes back off from DY_LINK_BACKOFF_MIN to
+  DY_LINK_BACKOFF_MAX and the link recovers on the first answered probe. The
+  module browns out meanwhile, the settings are restored on recovery. Exits
+  with 1 if a check fails.
+  Build with e.g.:
+    g++ -std=c++11 -Isrc examples/host/LinkHealth.cpp src/DYPlayer.cpp \
+      src/DYLink.cpp src/DYProfile.cpp src/DYStorage.cpp \
+      src/DYSimulator.cpp -o linkhealth
+*/
+#if defined(__unix__) && !defined(ARDUINO) && !defined(ESP_PLATFORM)
+#include <stdio.h>
+#include <vector>
+#include "DYLink.h"
+#include "DYProfile.h"
+#include "DYSimulator.h"
+
+// Time between calls of the program's loop, in milliseconds.
+#define LOOP_INTERVAL 10
+
+static int failed = 0;
+static int changes[2] = {0, 0};
+
+#define CHECK(condition)                                             \
+  do                                                                 \
+  {                                                                  \
+    if (!(condition))                                                \
+    {                                                                \
+      printf("%s:%d: failed: %s\n", __FILE__, __LINE__, #condition); \
+      failed++;                                                      \
+    }                                                                \
+  } while (0)
+
+void onLinkChange(bool up)
+{
+  changes[up ? 1 : 0]++;
+}
+
+// Run the loop while the link is down, until it's up or after a while, and
+// return when each probe was sent.
+std::vector<uint32_t> whileDown(DY::SimPlayer *player, DY::LinkHealth *link,
+                                uint32_t ms)
+{
+  std::vector<uint32_t> probes;
+  uint32_t start = player->timeMs();
+  while (!link->isUp() && player->timeMs() - start < ms)
+  {
+    uint32_t sent = link->counters.probes;
+    uint32_t now = player->timeMs();
+    link->checkPlayState();
+    if (link->counters.probes > sent)
+      probes.push_back(now);
+    player->delayMs(LOOP_INTERVAL);
+  }
+  return probes;
+}
+
+int main()
+{
+  DY::Simulation sim;
+  DY::SimModule module(&sim);
+  DY::SimPlayer player(&sim, &module);
+  // Shorter than the backoff, so probes are spaced by the backoff alone.
+  player.setReadTimeout(100);
+  DY::LinkHealth link(&player);
+  link.onChange = onLinkChange;
+  // Only restored, never loaded or saved here.
+  DY::FileStorage storage("linkhealth.bin");
+  DY::Profile profile(&player, &storage);
+  link.profile = &profile;
+
+  // Up: answered right away.
+  CHECK(link.checkPlayState() == DY::PlayState::Stopped);
+  CHECK(link.isUp());
+  CHECK(link.counters.queries == 1 && link.counters.failures == 0);
+  CHECK(link.setVolume(10));
+  player.delayMs(LOOP_INTERVAL);
+  CHECK(module.getVolume() == 10);
+
+  // Unplugged: the first query fails and is retried, the next one fails
+  // DY_LINK_FAILURES in a row, no more retries then.
+  module.connect(nullptr);
+  CHECK(link.checkPlayState() == DY::PlayState::Fail);
+  CHECK(link.isUp());
+  CHECK(link.counters.retries == DY_LINK_RETRIES);
+  while (link.isUp() && link.counters.queries < 10)
+    link.checkPlayState();
+  uint32_t downAt = player.timeMs();
+  CHECK(!link.isUp());
+  CHECK(link.counters.failures == DY_LINK_FAILURES);
+  CHECK(link.counters.downs == 1 && changes[0] == 1);
+
+  // Down: queries fail without sending anything.
+  uint32_t bytes = module.stats.bytes;
+  CHECK(link.checkPlayState() == DY::PlayState::Fail);
+  CHECK(link.counters.fastFails == 1);
+  CHECK(module.stats.bytes == bytes);
+  // Settings aren't sent either, but kept for the recovery.
+  CHECK(!link.setVolume(12));
+  CHECK(link.counters.fastFails == 2);
+  CHECK(module.stats.bytes == bytes);
+  CHECK(profile.desired.volume == 12);
+
+  // The first probe is sent the minimum backoff after the link went down,
+  // every failed probe doubles the backoff, up to the maximum.
+  uint32_t queries = link.counters.queries;
+  uint32_t fastFails = link.counters.fastFails;
+  std::vector<uint32_t> probes = whileDown(&player, &link, 80000);
+  CHECK(!link.isUp());
+  CHECK(probes.size() >= 9);
+  uint32_t backoff = DY_LINK_BACKOFF_MIN;
+  for (size_t i = 0; i < probes.size(); i++)
+  {
+    uint32_t interval = probes[i] - (i == 0 ? downAt : probes[i - 1]);
+    printf("Probe %u after %ums, backoff %ums\n", (unsigned)i + 1, interval,
+           backoff);
+    CHECK(interval >= backoff && interval <= backoff + 2 * LOOP_INTERVAL);
+    backoff = backoff * 2 > DY_LINK_BACKOFF_MAX ? DY_LINK_BACKOFF_MAX
+                                                : backoff * 2;
+  }
+  CHECK(backoff == DY_LINK_BACKOFF_MAX);
+  CHECK(link.counters.probes == probes.size());
+  CHECK(link.counters.queries - queries == probes.size());
+  CHECK(link.counters.fastFails - fastFails > 0);
+  // Nothing but the probes was sent: a 4 byte query each, and the 5 byte
+  // response that doesn't arrive.
+  CHECK(module.stats.bytes - bytes == 9 * probes.size());
+
+  // Plugged in again after a brown-out: the next probe recovers the link
+  // and the settings are restored once, the module confirmed the device.
+  module.powerCycle();
+  CHECK(module.getVolume() == 20);
+  module.connect(&player);
+  probes = whileDown(&player, &link, DY_LINK_BACKOFF_MAX + 1000);
+  CHECK(link.isUp());
+  CHECK(probes.size() == 1);
+  CHECK(link.counters.ups == 1 && changes[1] == 1);
+  CHECK(link.counters.restores == 1);
+  // Writes return right away, let the settings arrive.
+  player.delayMs(20);
+  CHECK(module.getVolume() == 12);
+  CHECK(link.checkPlayState() == DY::PlayState::Stopped);
+
+  // Down again, the backoff starts over from the minimum.
+  module.connect(nullptr);
+  while (link.isUp())
+    link.checkPlayState();
+  downAt = player.timeMs();
+  CHECK(link.counters.downs == 2 && changes[0] == 2);
+  probes = whileDown(&player, &link, 1000);
+  CHECK(probes.size() >= 1);
+  if (probes.size() >= 1)
+    CHECK(probes[0] - downAt <= DY_LINK_BACKOFF_MIN + 2 * LOOP_INTERVAL);
+
+  printf("Queries: %u, failures: %u, retries: %u, probes: %u, fast fails: "
+         "%u, downs: %u, ups: %u, restores: %u\n",
+         link.counters.queries, link.counters.failures, link.counters.retries,
+         link.counters.probes, link.counters.fastFails, link.counters.downs,
+         link.counters.ups, link.counters.restores);
+  printf(failed ? "%d checks failed\n" : "All checks passed\n", failed);
+  return failed ? 1 : 0;
+}
+#endif
@@ -0,0 +1,287 @@
+/*
+  Compare playlist strategies on simulated modules: each module plays its
+  sounds in order, the strategies differ in how the program finds out that a
+  sound ended. Runs in virtual time, spread over all cores.
+  Build with e.g.:
+    g++ -std=c++11 -O2 -Isrc examples/host/Simulate.cpp src/DYPlayer.cpp \
+      src/DYSimulator.cpp -o simulate -pthread
+  Run with the amount of modules, hours and threads (all optional):
+    ./simulate 256 1 4
+*/
+#if defined(__unix__) && !defined(ARDUINO) && !defined(ESP_PLATFORM)
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "DYSimulator.h"
+
+// Modules driven by a single program (and a single simulation).
+#define MODULES_PER_PROGRAM 8
+// Time between play state checks when polling, in milliseconds.
+#define POLL_INTERVAL 250
+
+typedef struct
+{
+  uint64_t moduleUs;  // Time simulated, summed over modules.
+  uint64_t playingUs; // Time playing, summed over modules.
+  uint64_t plays;     // Sounds started.
+  uint64_t bytes;     // Bytes on the lines.
+  uint64_t failed;    // Queries without a (valid) response.
+  uint64_t dropped;   // Frames dropped by busy or confused modules.
+  uint64_t events;    // Events handled by the simulations.
+} result_t;
+
+// A program driving a few modules, with its own simulation.
+class Program
+{
+public:
+  DY::Simulation sim;
+  std::vector<std::unique_ptr<DY::SimModule>> modules;
+  std::vector<std::unique_ptr<DY::SimPlayer>> players;
+  std::vector<uint16_t> next;
+  uint64_t failed = 0;
+
+  Program(uint32_t seed)
+  {
+    std::mt19937 random(seed);
+    for (int i = 0; i < MODULES_PER_PROGRAM; i++)
+    {
+      DY::SimModule *module = new DY::SimModule(&sim, random());
+      // Rough figures, measure your modules, e.g. with calibrateGaps().
+      module->config.busyUs[(uint8_t)DY::Gap::Control] = 20000;
+      module->config.busyUs[(uint8_t)DY::Gap::Play] = 40000;
+      module->config.busyUs[(uint8_t)DY::Gap::Device] = 300000;
+      module->config.errorRate = 0.0001;
+      for (int t = 0; t < 50; t++)
+        module->tracks.push_back(20000 + random() % 220000);
+      modules.emplace_back(module);
+      players.emplace_back(new DY::SimPlayer(&sim, module));
+      next.push_back(1);
+    }
+  }
+
+  void playNext(int i)
+  {
+    players[i]->playSpecified(next[i]);
+    next[i] = next[i] % modules[i]->tracks.size() + 1;
+  }
+
+  // Query the play state of some modules at the same time.
+  void checkAll(const std::vector<int> &which, std::vector<DY::play_state_t> &states)
+  {
+    for (int i : which)
+      players[i]->beginQuery(DY::Query::PlayState);
+    std::vector<bool> done(which.size(), false);
+    size_t left = which.size();
+    while (left > 0)
+    {
+      for (size_t j = 0; j < which.size(); j++)
+      {
+        if (done[j])
+          continue;
+        uint16_t value;
+        DY::query_state_t state = players[which[j]]->pollQuery(&value);
+        if (state == DY::QueryState::Pending)
+          continue;
+        states[which[j]] = state == DY::QueryState::Done
+                               ? (DY::play_state_t)value
+                               : DY::PlayState::Fail;
+        if (state == DY::QueryState::Fail)
+          failed++;
+        done[j] = true;
+        left--;
+      }
+      if (left > 0)
+        sim.run(sim.now + 1000);
+    }
+  }
+
+  // Check each module in turn, waiting for each response.
+  void blocking(uint64_t end)
+  {
+    while (sim.now < end)
+    {
+      for (size_t i = 0; i < players.size(); i++)
+      {
+        DY::play_state_t state = players[i]->checkPlayState();
+        if (state == DY::PlayState::Fail)
+          failed++;
+        else if (state == DY::PlayState::Stopped)
+          playNext(i);
+      }
+      players[0]->delayMs(POLL_INTERVAL);
+    }
+  }
+
+  // Check all modules at the same time, at a fixed interval.
+  void pipelined(uint64_t end)
+  {
+    for (auto &player : players)
+      player->setReadTimeout(0);
+    std::vector<int> all;
+    for (size_t i = 0; i < players.size(); i++)
+      all.push_back(i);
+    std::vector<DY::play_state_t> states(players.size());
+    while (sim.now < end)
+    {
+      uint64_t sweep = sim.now;
+      checkAll(all, states);
+      for (size_t i = 0; i < players.size(); i++)
+      {
+        if (states[i] == DY::PlayState::Stopped)
+          playNext(i);
+      }
+      sim.run(sweep + POLL_INTERVAL * 1000ULL);
+    }
+  }
+
+  // Knows how long sounds last, checks only when a sound should have ended.
+  void timed(uint64_t end)
+  {
+    for (auto &player : players)
+      player->setReadTimeout(0);
+    std::vector<uint64_t> due(players.size(), 0);
+    std::vector<DY::play_state_t> states(players.size());
+    while (sim.now < end)
+    {
+      uint64_t first = end;
+      for (uint64_t at : due)
+        first = at < first ? at : first;
+      sim.run(first);
+      std::vector<int> which;
+      for (size_t i = 0; i < players.size(); i++)
+      {
+        if (due[i] <= sim.now)
+          which.push_back(i);
+      }
+      if (which.empty())
+        continue;
+      checkAll(which, states);
+      for (int i : which)
+      {
+        if (states[i] == DY::PlayState::Stopped)
+        {
+          uint16_t sound = next[i];
+          playNext(i);
+          // Check again right after it should have ended.
+          due[i] = sim.now + modules[i]->tracks[sound - 1] * 1000ULL + 50000;
+        }
+        else
+        {
+          due[i] = sim.now + (states[i] == DY::PlayState::Fail ? 100000 : 20000);
+        }
+      }
+    }
+  }
+
+  // The module plays the sounds in sequence by itself, checked now and then.
+  void cycle(uint64_t end)
+  {
+    for (size_t i = 0; i < players.size(); i++)
+    {
+      players[i]->setCycleMode(DY::PlayMode::Repeat);
+      players[i]->delayMs(POLL_INTERVAL);
+      playNext(i);
+    }
+    while (sim.now < end)
+    {
+      players[0]->delayMs(10000);
+      for (size_t i = 0; i < players.size(); i++)
+      {
+        DY::play_state_t state = players[i]->checkPlayState();
+        if (state == DY::PlayState::Fail)
+        {
+          failed++;
+        }
+        else if (state == DY::PlayState::Stopped)
+        {
+          // The cycle mode or play command was lost, try again.
+          players[i]->setCycleMode(DY::PlayMode::Repeat);
+          players[i]->delayMs(POLL_INTERVAL);
+          playNext(i);
+        }
+      }
+    }
+  }
+
+  void add(result_t &result)
+  {
+    for (auto &module : modules)
+    {
+      result.moduleUs += sim.now;
+      result.playingUs += module->playing();
+      result.plays += module->stats.plays;
+      result.bytes += module->stats.bytes;
+      result.dropped += module->stats.dropped + module->stats.corrupt;
+    }
+    result.failed += failed;
+    result.events += sim.handled;
+  }
+};
+
+int main(int argc, char **argv)
+{
+  int modules = argc > 1 ? atoi(argv[1]) : 256;
+  double hours = argc > 2 ? atof(argv[2]) : 1;
+  int threads = argc > 3 ? atoi(argv[3]) : std::thread::hardware_concurrency();
+  if (threads < 1)
+    threads = 1;
+  int programs = (modules + MODULES_PER_PROGRAM - 1) / MODULES_PER_PROGRAM;
+  uint64_t end = hours * 3600e6;
+  const char *names[] = {"blocking", "pipelined", "timed", "cycle"};
+
+  printf("%d modules, %.1f hours, %d threads\n", programs * MODULES_PER_PROGRAM,
+         hours, threads);
+  printf("strategy    silence/sound (ms)  bytes/module-h  failed  dropped"
+         "  events/s  speedup\n");
+  for (int strategy = 0; strategy < 4; strategy++)
+  {
+    result_t result = {0, 0, 0, 0, 0, 0, 0};
+    std::mutex lock;
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++)
+    {
+      workers.emplace_back([&, t]()
+                           {
+        for (int p = t; p < programs; p += threads)
+        {
+          // The same seed for each strategy, so they get the same modules.
+          Program program(p + 1);
+          switch (strategy)
+          {
+          case 0:
+            program.blocking(end);
+            break;
+          case 1:
+            program.pipelined(end);
+            break;
+          case 2:
+            program.timed(end);
+            break;
+          default:
+            program.cycle(end);
+          }
+          std::lock_guard<std::mutex> guard(lock);
+          program.add(result);
+        } });
+    }
+    for (auto &worker : workers)
+      worker.join();
+    double wall = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+    double moduleHours = result.moduleUs / 3600e6;
+    printf("%-11s %18.1f %15.0f %7llu %8llu %9.2e %8.0fx\n", names[strategy],
+           (result.moduleUs - result.playingUs) / 1000.0 / result.plays,
+           result.bytes / moduleHours, (unsigned long long)result.failed,
+           (unsigned long long)result.dropped, result.events / wall,
+           result.moduleUs / 1e6 / wall);
+  }
+  return 0;
+}
+#endif
@@ -0,0 +1,51 @@
+/*
+  The part of the ESP-IDF UART driver API used by DYPlayerESP32.cpp, for the
+  host model in Esp32Tx.cpp. Not the real driver.
+*/
+#ifndef DY_MODEL_UART_H
+#define DY_MODEL_UART_H
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int uart_port_t;
+typedef int esp_err_t;
+typedef uint32_t TickType_t;
+typedef void *QueueHandle_t;
+
+#define ESP_OK 0
+#define ESP_ERR_TIMEOUT 0x107
+#define ESP_ERROR_CHECK(x) (x)
+#define portTICK_PERIOD_MS 10
+#define UART_NUM_2 2
+
+enum
+{
+  UART_DATA_8_BITS,
+  UART_PARITY_DISABLE,
+  UART_STOP_BITS_1,
+  UART_HW_FLOWCTRL_DISABLE
+};
+
+typedef struct
+{
+  int baud_rate;
+  int data_bits;
+  int parity;
+  int stop_bits;
+  int flow_ctrl;
+  int rx_flow_ctrl_thresh;
+  bool use_ref_tick;
+} uart_config_t;
+
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t *config);
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx, int rx, int rts, int cts);
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size,
+                              int tx_buffer_size, int queue_size,
+                              QueueHandle_t *uart_queue, int intr_alloc_flags);
+int uart_write_bytes(uart_port_t uart_num, const char *src, size_t size);
+esp_err_t uart_wait_tx_done(uart_port_t uart_num, TickType_t ticks_to_wait);
+esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t *size);
+int uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length,
+                    TickType_t ticks_to_wait);
+esp_err_t uart_flush_input(uart_port_t uart_num);
+#endif
@@ -0,0 +1,3 @@
+// Host model stand-in, see driver/uart.h.
+#include <stdint.h>
+int64_t esp_timer_get_time();
@@ -0,0 +1 @@
+// Host model stand-in, see driver/uart.h.
@@ -0,0 +1,3 @@
+// Host model stand-in, see driver/uart.h.
+#include <stdint.h>
+void vTaskDelay(uint32_t ticks);
@@ -0,0 +1,15 @@
+// Host model stand-in, see driver/uart.h.
+#include <stddef.h>
+typedef int nvs_handle_t;
+enum
+{
+  NVS_READONLY,
+  NVS_READWRITE
+};
+int nvs_open(const char *name, int mode, nvs_handle_t *handle);
+int nvs_get_blob(nvs_handle_t handle, const char *key, void *value,
+                 size_t *length);
+int nvs_set_blob(nvs_handle_t handle, const char *key, const void *value,
+                 size_t length);
+int nvs_commit(nvs_handle_t handle);
+void nvs_close(nvs_handle_t handle);
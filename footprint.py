@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""
+Build examples/footprint for every env in platformio.ini, in every build
+profile, and check the flash and RAM used against the budgets kept in
+footprint.json. Exits non-zero when a build fails, when a profile grew
+beyond its budget or when a profile has no budget. Record the budgets with
+--update (and commit footprint.json) before using it to guard changes in CI.
+
+Usage:
+    ./footprint.py            # Check all envs and profiles.
+    ./footprint.py -e uno     # Check some envs only (repeat -e).
+    ./footprint.py --update   # Record the current sizes as the budgets.
+"""
+
+import argparse
+import configparser
+import json
+import os
+import re
+import subprocess
+import sys
+
+BUDGETS_FILE = "footprint.json"
+#: Build profiles, the feature switches each defines, see DYPlayer.h.
+PROFILES = {
+    "full": [],
+    "no-paths": ["DY_NO_PATHS"],
+    "no-interlude": ["DY_NO_INTERLUDE"],
+    "no-combination-play": ["DY_NO_COMBINATION_PLAY"],
+    "no-gaps": ["DY_NO_GAPS"],
+    "no-batch": ["DY_NO_BATCH"],
+    "minimal": [
+        "DY_NO_PATHS",
+        "DY_NO_INTERLUDE",
+        "DY_NO_COMBINATION_PLAY",
+        "DY_NO_GAPS",
+        "DY_NO_BATCH",
+    ],
+    # Components on top of the player, their cost is the difference with
+    # "full" ("software-serial" for the trigger queue), see examples/footprint.
+    "software-serial": ["DY_FOOTPRINT_SOFTWARE_SERIAL"],
+    "trigger-queue": [
+        "DY_FOOTPRINT_SOFTWARE_SERIAL",
+        "DY_FOOTPRINT_TRIGGER_QUEUE",
+    ],
+    "script": ["DY_FOOTPRINT_SCRIPT"],
+    "content-index": ["DY_FOOTPRINT_CONTENT_INDEX"],
+    "profile": ["DY_FOOTPRINT_PROFILE"],
+    "link-health": ["DY_FOOTPRINT_LINK_HEALTH"],
+}
+#: Matches PlatformIO's size summary, e.g.:
+#: RAM:   [=         ]   9.5% (used 195 bytes from 2048 bytes)
+#: Flash: [=         ]   7.2% (used 2332 bytes from 32256 bytes)
+RE_USAGE = re.compile(r"^(RAM|Flash):.*\(used (\d+) bytes", re.MULTILINE)
+
+
+def envs():
+    """List the envs in platformio.ini."""
+    config = configparser.ConfigParser()
+    config.read("platformio.ini")
+    return [s[4:] for s in config.sections() if s.startswith("env:")]
+
+
+def build(env, defines):
+    """Build the footprint program, return {"flash": n, "ram": n} or None."""
+    flags = ["-DDY_FOOTPRINT"] + ["-D" + define for define in defines]
+    environment = dict(
+        os.environ,
+        PLATFORMIO_BUILD_FLAGS=" ".join(flags),
+        # Appended to the env's src_filter, only keep the footprint program.
+        PLATFORMIO_SRC_FILTER="-<*> +<footprint/>",
+    )
+    result = subprocess.run(
+        ["pio", "run", "-e", env],
+        env=environment,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.STDOUT,
+        universal_newlines=True,
+    )
+    usage = dict((k.lower(), int(v)) for k, v in RE_USAGE.findall(result.stdout))
+    if result.returncode != 0 or len(usage) != 2:
+        sys.stderr.write(result.stdout)
+        return None
+    return usage
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("-e", "--environment", action="append",
+                        help="env to build, default: all")
+    parser.add_argument("-p", "--profile", action="append",
+                        choices=sorted(PROFILES), help="default: all")
+    parser.add_argument("--update", action="store_true",
+                        help="record the sizes as the new budgets")
+    args = parser.parse_args()
+
+    budgets = {}
+    if os.path.exists(BUDGETS_FILE):
+        with open(BUDGETS_FILE) as f:
+            budgets = json.load(f)
+
+    failed = False
+    grew = False
+    missing = False
+    print("%-22s %-20s %16s %16s" % ("env", "profile", "flash", "ram"))
+    for env in args.environment or envs():
+        for profile in args.profile or PROFILES:
+            usage = build(env, PROFILES[profile])
+            if usage is None:
+                print("%-22s %-20s build failed" % (env, profile))
+                failed = True
+                continue
+            budget = budgets.get(env, {}).get(profile)
+            columns = []
+            for key in ("flash", "ram"):
+                column = str(usage[key])
+                if budget is not None:
+                    grown = usage[key] - budget[key]
+                    column += " (%+d)" % grown
+                    if grown > 0:
+                        column += " !"
+                        grew = True
+                else:
+                    column += " (?)"
+                    missing = True
+                columns.append(column)
+            print("%-22s %-20s %16s %16s" % (env, profile, *columns))
+            if args.update:
+                budgets.setdefault(env, {})[profile] = usage
+
+    if args.update:
+        with open(BUDGETS_FILE, "w") as f:
+            json.dump(budgets, f, indent=2, sort_keys=True)
+            f.write("\n")
+    elif grew:
+        print("Over budget (!), run with --update if the growth is intended.")
+    if missing and not args.update:
+        print("No budget (?), run with --update to record it.")
+    return 1 if failed or ((grew or missing) and not args.update) else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
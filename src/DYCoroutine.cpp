@@ -0,0 +1,221 @@
+/**
+ * C++20 coroutine layer for builds on a computer, see DYCoroutine.h.
+ */
+#include "DYCoroutine.h"
+#if __cplusplus >= 202002L && !defined(ARDUINO) && !defined(ESP_PLATFORM)
+#include <chrono>
+#include <new>
+#include <thread>
+
+namespace DY
+{
+  frame_stats_t FramePool::stats = {0, 0, 0, 0, 0};
+  FramePool::Free *FramePool::free[DY_FRAME_POOL_CLASSES] = {};
+
+  int8_t FramePool::sizeClass(size_t size)
+  {
+    size_t classSize = 64;
+    for (int8_t i = 0; i < DY_FRAME_POOL_CLASSES; i++, classSize <<= 1)
+    {
+      if (size <= classSize)
+        return i;
+    }
+    return -1;
+  }
+
+  void *FramePool::allocate(size_t size)
+  {
+    stats.allocations++;
+    if (++stats.inUse > stats.peak)
+      stats.peak = stats.inUse;
+    int8_t i = sizeClass(size);
+    if (i >= 0 && free[i] != nullptr)
+    {
+      Free *frame = free[i];
+      free[i] = frame->next;
+      stats.reused++;
+      return frame;
+    }
+    stats.heap++;
+    // Allocate the whole class, so the frame can be reused for any size in it.
+    return ::operator new(i >= 0 ? (size_t)64 << i : size);
+  }
+
+  void FramePool::deallocate(void *frame, size_t size)
+  {
+    stats.inUse--;
+    int8_t i = sizeClass(size);
+    if (i < 0)
+    {
+      ::operator delete(frame);
+      return;
+    }
+    Free *node = (Free *)frame;
+    node->next = free[i];
+    free[i] = node;
+  }
+
+  uint32_t Executor::timeMs()
+  {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  void Executor::idle()
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  void Executor::spawn(Task<void> &&task)
+  {
+    std::coroutine_handle<> handle = task.release();
+    tasks.push_back(handle);
+    handle.resume();
+    reap();
+  }
+
+  void Executor::wait(Waiter *waiter)
+  {
+    waiters.push_back(waiter);
+  }
+
+  bool Executor::runOnce()
+  {
+    bool resumed = false;
+    // Resumed coroutines may add waiters, poll the current ones only.
+    std::vector<Waiter *> pending;
+    pending.swap(waiters);
+    for (Waiter *waiter : pending)
+    {
+      if (waiter->poll())
+      {
+        waiter->handle.resume();
+        resumed = true;
+      }
+      else
+      {
+        waiters.push_back(waiter);
+      }
+    }
+    reap();
+    return resumed;
+  }
+
+  void Executor::run()
+  {
+    while (!tasks.empty())
+    {
+      if (!runOnce())
+        idle();
+    }
+  }
+
+  void Executor::reap()
+  {
+    for (size_t i = 0; i < tasks.size();)
+    {
+      if (tasks[i].done())
+      {
+        tasks[i].destroy();
+        tasks[i] = tasks.back();
+        tasks.pop_back();
+      }
+      else
+      {
+        i++;
+      }
+    }
+  }
+
+  Executor::~Executor()
+  {
+    for (std::coroutine_handle<> task : tasks)
+      task.destroy();
+  }
+
+  QueryAwaiter::QueryAwaiter(AsyncPlayer *player, query_t query,
+                             std::stop_token stop)
+      : player(player), query(query), stop(stop) {}
+
+  void QueryAwaiter::await_suspend(std::coroutine_handle<> h)
+  {
+    handle = h;
+    player->executor->wait(this);
+  }
+
+  bool QueryAwaiter::poll()
+  {
+    if (!sent)
+    {
+      if (stop.stop_requested())
+        return true;
+      // Wait for the query that is in flight to the same module.
+      if (player->busy)
+        return false;
+      player->busy = true;
+      player->player->beginQuery(query);
+      sent = true;
+      return false;
+    }
+    query_state_t state = player->player->pollQuery(&value);
+    if (state == QueryState::Pending)
+      return false;
+    player->busy = false;
+    ok = state == QueryState::Done;
+    return true;
+  }
+
+  SleepAwaiter::SleepAwaiter(Executor *executor, uint32_t ms,
+                             std::stop_token stop)
+      : executor(executor), start(executor->timeMs()), ms(ms), stop(stop) {}
+
+  void SleepAwaiter::await_suspend(std::coroutine_handle<> h)
+  {
+    handle = h;
+    executor->wait(this);
+  }
+
+  bool SleepAwaiter::poll()
+  {
+    return stop.stop_requested() || executor->timeMs() - start >= ms;
+  }
+
+  AsyncPlayer::AsyncPlayer(DYPlayer *player, Executor *executor)
+      : player(player), executor(executor) {}
+
+  QueryAwaiter AsyncPlayer::query(query_t query, std::stop_token stop)
+  {
+    return QueryAwaiter(this, query, stop);
+  }
+
+  PlayStateAwaiter AsyncPlayer::checkPlayState(std::stop_token stop)
+  {
+    return PlayStateAwaiter(this, stop);
+  }
+
+  SleepAwaiter AsyncPlayer::sleep(uint32_t ms, std::stop_token stop)
+  {
+    return SleepAwaiter(executor, ms, stop);
+  }
+
+  Task<bool> AsyncPlayer::waitUntilStopped(uint32_t timeoutMs,
+                                           uint32_t intervalMs,
+                                           std::stop_token stop)
+  {
+    uint32_t start = executor->timeMs();
+    while (true)
+    {
+      play_state_t state = co_await checkPlayState(stop);
+      if (state == PlayState::Stopped)
+        co_return true;
+      if (state == PlayState::Fail || stop.stop_requested())
+        co_return false;
+      if (executor->timeMs() - start >= timeoutMs)
+        co_return false;
+      if (!co_await sleep(intervalMs, stop))
+        co_return false;
+    }
+  }
+}
+#endif
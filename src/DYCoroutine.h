@@ -0,0 +1,342 @@
+/**
+ * C++20 coroutine layer for builds on a computer, e.g.:
+ *
+ * ```cpp
+ * DY::Task<void> show(DY::AsyncPlayer &player)
+ * {
+ *   player.player->playSpecified(1);
+ *   co_await player.waitUntilStopped(60000);
+ *   DY::play_state_t state = co_await player.checkPlayState();
+ * }
+ * ```
+ *
+ * A single threaded `DY::Executor` runs the coroutines and polls the players
+ * for responses, so one thread can drive many modules. The players should not
+ * wait for responses, e.g. `DY::Player::setReadTimeout(0)` on Linux.
+ *
+ * Coroutine frames are allocated from `DY::FramePool`, which keeps freed
+ * frames for reuse, so a steady state program doesn't allocate.
+ */
+#ifndef DY_COROUTINE_H
+#define DY_COROUTINE_H
+#if __cplusplus >= 202002L && !defined(ARDUINO) && !defined(ESP_PLATFORM)
+#include <coroutine>
+#include <exception>
+#include <stddef.h>
+#include <stdint.h>
+#include <stop_token>
+#include <utility>
+#include <vector>
+#include "DYPlayer.h"
+
+// Frame sizes kept by the pool: 64, 128, .. up to 64 << (classes - 1).
+#ifndef DY_FRAME_POOL_CLASSES
+#define DY_FRAME_POOL_CLASSES 5
+#endif
+
+namespace DY
+{
+  /**
+   * Allocation counters kept by `DY::FramePool`.
+   */
+  typedef struct
+  {
+    uint32_t allocations; // Frames allocated.
+    uint32_t reused;      // Frames taken from the pool, not the heap.
+    uint32_t heap;        // Frames allocated on the heap.
+    uint32_t inUse;       // Frames currently allocated.
+    uint32_t peak;        // Most frames allocated at the same time.
+  } frame_stats_t;
+
+  /**
+   * Free lists of coroutine frames by size class, single threaded like the
+   * executor. Frames larger than the largest class go to the heap directly.
+   */
+  class FramePool
+  {
+  public:
+    static frame_stats_t stats;
+    static void *allocate(size_t size);
+    static void deallocate(void *frame, size_t size);
+
+  private:
+    struct Free
+    {
+      Free *next;
+    };
+    static Free *free[DY_FRAME_POOL_CLASSES];
+    static int8_t sizeClass(size_t size);
+  };
+
+  /**
+   * Something a suspended coroutine waits for, polled by the executor.
+   */
+  class Waiter
+  {
+  public:
+    std::coroutine_handle<> handle;
+    /**
+     * @return Done waiting, resume the coroutine (true) or not (false).
+     */
+    virtual bool poll() = 0;
+  };
+
+  template <typename T>
+  class Task;
+
+  class Executor
+  {
+  public:
+    /**
+     * Start a coroutine, the executor keeps it until it's done.
+     * @param task to run.
+     */
+    void spawn(Task<void> &&task);
+
+    /**
+     * Poll all waiters once and resume the coroutines that are done waiting.
+     * @return Coroutines were resumed (true), or none were (false).
+     */
+    bool runOnce();
+
+    /**
+     * Run until all coroutines are done, calls `idle()` whenever no
+     * coroutine could be resumed.
+     */
+    void run();
+
+    /**
+     * Suspend a coroutine until the waiter is done.
+     * @param waiter to poll.
+     */
+    void wait(Waiter *waiter);
+
+    /**
+     * Clock of the sleeps and timeouts, the steady clock by default. Can be
+     * overridden along with `idle()` to run in virtual time, e.g. that of a
+     * `DY::Simulation`.
+     * @return Milliseconds since an arbitrary moment.
+     */
+    virtual uint32_t timeMs();
+
+    /**
+     * Let time pass when no coroutine could be resumed, sleeps a millisecond
+     * by default.
+     */
+    virtual void idle();
+
+    virtual ~Executor();
+
+  private:
+    std::vector<Waiter *> waiters;
+    std::vector<std::coroutine_handle<>> tasks;
+    void reap();
+  };
+
+  namespace detail
+  {
+    struct PromiseBase
+    {
+      std::coroutine_handle<> continuation;
+
+      static void *operator new(size_t size)
+      {
+        return FramePool::allocate(size);
+      }
+      static void operator delete(void *frame, size_t size)
+      {
+        FramePool::deallocate(frame, size);
+      }
+
+      std::suspend_always initial_suspend() noexcept { return {}; }
+
+      struct Final
+      {
+        bool await_ready() noexcept { return false; }
+        template <typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept
+        {
+          // Continue with whoever awaited this task, if anyone.
+          std::coroutine_handle<> next = h.promise().continuation;
+          return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+      };
+      Final final_suspend() noexcept { return {}; }
+
+      void unhandled_exception() { std::terminate(); }
+    };
+
+    template <typename T>
+    struct Promise : PromiseBase
+    {
+      T value{};
+      void return_value(T v) { value = std::move(v); }
+      T result() { return std::move(value); }
+    };
+
+    template <>
+    struct Promise<void> : PromiseBase
+    {
+      void return_void() {}
+      void result() {}
+    };
+  }
+
+  /**
+   * A coroutine returning `T`, starts when it's awaited or spawned.
+   */
+  template <typename T>
+  class Task
+  {
+  public:
+    struct promise_type : detail::Promise<T>
+    {
+      Task get_return_object()
+      {
+        return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+      }
+    };
+
+    Task(Task &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task(const Task &) = delete;
+    ~Task()
+    {
+      if (handle)
+        handle.destroy();
+    }
+
+    bool await_ready() noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+      handle.promise().continuation = awaiting;
+      return handle;
+    }
+    T await_resume() { return handle.promise().result(); }
+
+    /**
+     * Hand over the coroutine, used by `DY::Executor::spawn()`.
+     */
+    std::coroutine_handle<promise_type> release()
+    {
+      return std::exchange(handle, nullptr);
+    }
+
+  private:
+    explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+    std::coroutine_handle<promise_type> handle;
+  };
+
+  class AsyncPlayer;
+
+  /**
+   * Awaits the response to a query, queries to the same player wait for
+   * each other. Cancelling takes effect before the query is sent, a query
+   * that was sent completes or times out (see `DY_QUERY_TIMEOUT`).
+   */
+  class QueryAwaiter : public Waiter
+  {
+  public:
+    QueryAwaiter(AsyncPlayer *player, query_t query, std::stop_token stop);
+    bool await_ready() { return false; }
+    void await_suspend(std::coroutine_handle<> h);
+    bool poll();
+    /**
+     * @return Response value, check `ok` for failure.
+     */
+    uint16_t await_resume() { return value; }
+    bool ok = false;
+
+  protected:
+    AsyncPlayer *player;
+    query_t query;
+    std::stop_token stop;
+    bool sent = false;
+    uint16_t value = 0;
+  };
+
+  /**
+   * Awaits the play state, `DY::PlayState::Fail` on failure.
+   */
+  class PlayStateAwaiter : public QueryAwaiter
+  {
+  public:
+    PlayStateAwaiter(AsyncPlayer *player, std::stop_token stop)
+        : QueryAwaiter(player, Query::PlayState, stop) {}
+    play_state_t await_resume()
+    {
+      return ok ? (play_state_t)value : PlayState::Fail;
+    }
+  };
+
+  /**
+   * Awaits a moment in time, or cancellation.
+   */
+  class SleepAwaiter : public Waiter
+  {
+  public:
+    SleepAwaiter(Executor *executor, uint32_t ms, std::stop_token stop);
+    bool await_ready() { return false; }
+    void await_suspend(std::coroutine_handle<> h);
+    bool poll();
+    /**
+     * @return Slept (true), or cancelled (false).
+     */
+    bool await_resume() { return !stop.stop_requested(); }
+
+  private:
+    Executor *executor;
+    uint32_t start;
+    uint32_t ms;
+    std::stop_token stop;
+  };
+
+  class AsyncPlayer
+  {
+  public:
+    DYPlayer *player;
+    Executor *executor;
+    bool busy = false; // A query is in flight.
+
+    /**
+     * @param player to send queries to, it should not wait for responses.
+     * @param executor that runs the coroutines using this player.
+     */
+    AsyncPlayer(DYPlayer *player, Executor *executor);
+
+    /**
+     * Await a query, see `DY::DYPlayer::query()`.
+     * @param query A [`DY::Query` member](#typedef-enum-class-dyquery_t).
+     * @param stop token to cancel the query before it's sent.
+     * @return Awaitable for the response value, check its `ok` member.
+     */
+    QueryAwaiter query(query_t query, std::stop_token stop = {});
+
+    /**
+     * Await the current play state.
+     * @param stop token to cancel the query before it's sent.
+     * @return Awaitable for the play state, `DY::PlayState::Fail` on failure.
+     */
+    PlayStateAwaiter checkPlayState(std::stop_token stop = {});
+
+    /**
+     * Await a while.
+     * @param ms Milliseconds to sleep.
+     * @param stop token to wake up early.
+     * @return Awaitable, `true` if it slept, `false` if cancelled.
+     */
+    SleepAwaiter sleep(uint32_t ms, std::stop_token stop = {});
+
+    /**
+     * Check the play state until the module stopped playing.
+     * @param timeoutMs Give up after this many milliseconds.
+     * @param intervalMs Milliseconds between checks.
+     * @param stop token to give up early.
+     * @return Stopped (true), timed out, cancelled or failed (false).
+     */
+    Task<bool> waitUntilStopped(uint32_t timeoutMs, uint32_t intervalMs = 100,
+                                std::stop_token stop = {});
+  };
+}
+#endif
+#endif
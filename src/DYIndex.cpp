@@ -0,0 +1,138 @@
+/**
+ * Index of the sound files and directories on the storage devices of the
+ * module, see DYIndex.h.
+ */
+#include <string.h>
+#include "DYIndex.h"
+
+namespace DY
+{
+  ContentIndex::ContentIndex(DYPlayer *player, Storage *storage)
+  {
+    this->player = player;
+    this->storage = storage;
+    snapshot.reset();
+  }
+
+  bool ContentIndex::begin()
+  {
+    bool loaded = load();
+    if (loaded && isCurrent())
+      return true;
+    if (scan())
+      save();
+    else if (loaded)
+      // The module didn't answer, e.g. not ready yet, keep the stored index.
+      load();
+    return false;
+  }
+
+  bool ContentIndex::queryDevice(device_t device, uint16_t *count)
+  {
+    *count = 0;
+    player->setPlayingDevice(device);
+    uint16_t playing;
+    if (!player->query(Query::PlayingDevice, &playing))
+      return false;
+    // The module stays on another device if this one is offline.
+    if (playing != (uint8_t)device)
+      return true;
+    return player->query(Query::SoundCount, count);
+  }
+
+  void ContentIndex::restoreDevice(device_t device)
+  {
+    if (getDevice(device) != NULL)
+      player->setPlayingDevice(device);
+  }
+
+  bool ContentIndex::isCurrent()
+  {
+    device_t playing = player->getPlayingDevice();
+    bool current = true;
+    for (uint8_t d = 0; d < 3 && current; d++)
+    {
+      uint16_t count;
+      current = queryDevice((device_t)d, &count) &&
+                count == snapshot.data[d].soundCount;
+    }
+    restoreDevice(playing);
+    return current;
+  }
+
+  bool ContentIndex::scan()
+  {
+    device_t playing = player->getPlayingDevice();
+    bool answered = playing != Device::Fail;
+    for (uint8_t d = 0; d < 3 && answered; d++)
+    {
+      device_index_t *index = &snapshot.data[d];
+      memset(index, 0, sizeof(device_index_t));
+      answered = queryDevice((device_t)d, &index->soundCount);
+      uint16_t number = 1;
+      while (answered && number <= index->soundCount &&
+             index->dirCount < DY_INDEX_MAX_DIRS)
+      {
+        player->select(number);
+        uint16_t first;
+        uint16_t count;
+        answered = player->query(Query::FirstInDir, &first) &&
+                   player->query(Query::SoundCountDir, &count);
+        // Stop rather than walking in circles.
+        if (!answered || count == 0 || first + count <= number)
+          break;
+        index->dirs[index->dirCount].first = first;
+        index->dirs[index->dirCount].count = count;
+        index->dirCount++;
+        number = first + count;
+      }
+    }
+    restoreDevice(playing);
+    return answered;
+  }
+
+  bool ContentIndex::load()
+  {
+    return snapshot.load(storage);
+  }
+
+  bool ContentIndex::save()
+  {
+    return snapshot.save(storage);
+  }
+
+  device_index_t *ContentIndex::getDevice(device_t device)
+  {
+    if ((uint8_t)device > (uint8_t)Device::Flash)
+      return NULL;
+    return &snapshot.data[(uint8_t)device];
+  }
+
+  uint16_t ContentIndex::getSoundCount(device_t device)
+  {
+    device_index_t *index = getDevice(device);
+    return index == NULL ? 0 : index->soundCount;
+  }
+
+  uint8_t ContentIndex::getDirCount(device_t device)
+  {
+    device_index_t *index = getDevice(device);
+    return index == NULL ? 0 : index->dirCount;
+  }
+
+  uint16_t ContentIndex::getFirstInDir(device_t device, uint8_t dir)
+  {
+    device_index_t *index = getDevice(device);
+    if (index == NULL || dir >= index->dirCount)
+      return 0;
+    return index->dirs[dir].first;
+  }
+
+  uint16_t ContentIndex::getSoundCountDir(device_t device, uint8_t dir)
+  {
+    device_index_t *index = getDevice(device);
+    if (index == NULL || dir >= index->dirCount)
+      return 0;
+    return index->dirs[dir].count;
+  }
+}
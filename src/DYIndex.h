@@ -0,0 +1,157 @@
+/**
+ * Index of the sound files and directories on the storage devices of the
+ * module. Walking the content of the module takes a few queries per directory,
+ * which adds up to seconds at 9600 baud. The index is kept in persistent
+ * storage and only rebuilt when the sound counts of the devices change.
+ */
+#ifndef DY_INDEX_H
+#define DY_INDEX_H
+#include <stdint.h>
+#include "DYPlayer.h"
+#include "DYStorage.h"
+
+// Maximum amount of directories kept per device, each uses 4 bytes of RAM and
+// storage, times 3 devices.
+#ifndef DY_INDEX_MAX_DIRS
+#define DY_INDEX_MAX_DIRS 8
+#endif
+
+#define DY_INDEX_MAGIC 0x49 // I
+#define DY_INDEX_VERSION 1
+
+namespace DY
+{
+  /**
+   * A directory on a storage device, by the number of the first sound in it
+   * and the amount of sounds in it.
+   */
+  typedef struct
+  {
+    uint16_t first;
+    uint16_t count;
+  } dir_index_t;
+
+  /**
+   * The content of a storage device, the total sound count doubles as the
+   * fingerprint to check whether the index is still valid.
+   */
+  typedef struct
+  {
+    uint16_t soundCount;
+    uint8_t dirCount;
+    dir_index_t dirs[DY_INDEX_MAX_DIRS];
+  } device_index_t;
+
+  class ContentIndex
+  {
+  public:
+    /**
+     * @param player to query the content of.
+     * @param storage to persist the index in.
+     */
+    ContentIndex(DYPlayer *player, Storage *storage);
+
+    /**
+     * Load the index from storage, if it isn't there or it doesn't match the
+     * content of the module anymore, rebuild it and store it.
+     * Call this while the module isn't playing, the storage devices are
+     * switched to check their content. The device that was playing is
+     * selected again afterwards. If the module doesn't answer a query, e.g.
+     * right after power up, nothing is stored and the stored index is kept.
+     * @return Index was loaded from storage and matches the module (true), or
+     *         it was rebuilt or the module didn't answer (false).
+     */
+    bool begin();
+
+    /**
+     * Check the sound count of each storage device against the index.
+     * Costs a device switch and 2 queries per device, as opposed to 1 select
+     * and 2 queries per directory to scan.
+     * @return Index matches the module content (true) or not, or the module
+     *         didn't answer (false).
+     */
+    bool isCurrent();
+
+    /**
+     * Rebuild the index by walking the directories on each storage device.
+     * Directories are walked using `DY::DYPlayer::select()` so no sound is
+     * played while scanning.
+     * @return All queries were answered (true), or not and the index is
+     *         incomplete (false).
+     */
+    bool scan();
+
+    /**
+     * Load the index from storage.
+     * @return Successful load (true), failure or invalid data (false).
+     */
+    bool load();
+
+    /**
+     * Save the index to storage.
+     * @return Successful save (true), failure (false).
+     */
+    bool save();
+
+    /**
+     * Get the index of a storage device.
+     * @param device A [`DY::Device` member](#typedef-enum-class-dydevice_t),
+     *               e.g  `DY::Device::Flash` or `DY::Device::Sd`.
+     * @return pointer to the index of the device, `NULL` if the device is
+     *         not a storage device.
+     */
+    device_index_t *getDevice(device_t device);
+
+    /**
+     * Get the amount of sound files on a storage device.
+     * @param device A [`DY::Device` member](#typedef-enum-class-dydevice_t).
+     * @return number of sound files.
+     */
+    uint16_t getSoundCount(device_t device);
+
+    /**
+     * Get the amount of directories indexed on a storage device.
+     * @param device A [`DY::Device` member](#typedef-enum-class-dydevice_t).
+     * @return number of directories.
+     */
+    uint8_t getDirCount(device_t device);
+
+    /**
+     * Get number of the first song in a directory.
+     * @param device A [`DY::Device` member](#typedef-enum-class-dydevice_t).
+     * @param dir index of the directory, starting at `0`.
+     * @return number of the first song in the directory, `0` if unknown.
+     */
+    uint16_t getFirstInDir(device_t device, uint8_t dir);
+
+    /**
+     * Get the amount of sound files in a directory.
+     * @param device A [`DY::Device` member](#typedef-enum-class-dydevice_t).
+     * @param dir index of the directory, starting at `0`.
+     * @return number of sound files in the directory, `0` if unknown.
+     */
+    uint16_t getSoundCountDir(device_t device, uint8_t dir);
+
+  private:
+    DYPlayer *player;
+    Storage *storage;
+
+    Snapshot<device_index_t[3], DY_INDEX_MAGIC, DY_INDEX_VERSION> snapshot;
+
+    /**
+     * Switch to a storage device and get its sound count.
+     * @param device A [`DY::Device` member](#typedef-enum-class-dydevice_t).
+     * @param count pointer to keep the number of sound files in, `0` if the
+     *              device is not online.
+     * @return Queries were answered (true), or communication failure (false).
+     */
+    bool queryDevice(device_t device, uint16_t *count);
+
+    /**
+     * Restore the device that was playing before switching devices.
+     * @param device as returned by `DY::DYPlayer::getPlayingDevice()`.
+     */
+    void restoreDevice(device_t device);
+  };
+}
+#endif
@@ -0,0 +1,177 @@
+/**
+ * Health of the UART link with the module, see DYLink.h.
+ */
+#include <string.h>
+#include "DYLink.h"
+
+namespace DY
+{
+  LinkHealth::LinkHealth(DYPlayer *player)
+  {
+    this->player = player;
+    this->onChange = 0;
+    this->profile = 0;
+    memset(&counters, 0, sizeof(counters));
+    up = true;
+    consecutive = 0;
+    backoff = DY_LINK_BACKOFF_MIN;
+    lastProbe = 0;
+  }
+
+  bool LinkHealth::isUp()
+  {
+    return up;
+  }
+
+  bool LinkHealth::attempt(query_t query, uint16_t *value)
+  {
+    counters.queries++;
+    if (player->query(query, value))
+    {
+      consecutive = 0;
+      if (!up)
+      {
+        up = true;
+        backoff = DY_LINK_BACKOFF_MIN;
+        counters.ups++;
+        restore();
+        if (onChange)
+          onChange(true);
+      }
+      return true;
+    }
+    counters.failures++;
+    if (up && ++consecutive >= DY_LINK_FAILURES)
+    {
+      up = false;
+      lastProbe = player->timeMs();
+      counters.downs++;
+      if (onChange)
+        onChange(false);
+    }
+    return false;
+  }
+
+  void LinkHealth::restore()
+  {
+    if (!profile)
+      return;
+    for (uint8_t i = 0; i < DY_LINK_RESTORES; i++)
+    {
+      counters.restores++;
+      if (profile->restore(false).verified)
+        return;
+    }
+  }
+
+  bool LinkHealth::probe(query_t query, uint16_t *value)
+  {
+    if (player->timeMs() - lastProbe < backoff)
+    {
+      counters.fastFails++;
+      return false;
+    }
+    counters.probes++;
+    lastProbe = player->timeMs();
+    if (attempt(query, value))
+      return true;
+    if (backoff < DY_LINK_BACKOFF_MAX)
+      backoff = backoff * 2 > DY_LINK_BACKOFF_MAX ? DY_LINK_BACKOFF_MAX
+                                                  : backoff * 2;
+    return false;
+  }
+
+  bool LinkHealth::query(query_t query, uint16_t *value)
+  {
+    if (!up)
+      return probe(query, value);
+    for (uint8_t i = 0; i <= DY_LINK_RETRIES && up; i++)
+    {
+      if (i > 0)
+        counters.retries++;
+      if (attempt(query, value))
+        return true;
+    }
+    return false;
+  }
+
+  play_state_t LinkHealth::checkPlayState()
+  {
+    uint16_t value;
+    if (query(Query::PlayState, &value))
+      return (play_state_t)value;
+    return PlayState::Fail;
+  }
+
+  device_t LinkHealth::getPlayingDevice()
+  {
+    uint16_t value;
+    if (query(Query::PlayingDevice, &value))
+      return (device_t)value;
+    return Device::Fail;
+  }
+
+  void LinkHealth::update()
+  {
+    uint16_t value;
+    if (!up && player->timeMs() - lastProbe >= backoff)
+      probe(Query::PlayState, &value);
+  }
+
+  bool LinkHealth::canSend()
+  {
+    if (!up)
+      counters.fastFails++;
+    return up;
+  }
+
+  bool LinkHealth::setVolume(uint8_t volume)
+  {
+    if (profile)
+      profile->desired.volume = volume;
+    if (!canSend())
+      return false;
+    player->setVolume(volume);
+    return true;
+  }
+
+  bool LinkHealth::setEq(eq_t eq)
+  {
+    if (profile)
+      profile->desired.eq = eq;
+    if (!canSend())
+      return false;
+    player->setEq(eq);
+    return true;
+  }
+
+  bool LinkHealth::setCycleMode(play_mode_t mode)
+  {
+    if (profile)
+      profile->desired.cycleMode = mode;
+    if (!canSend())
+      return false;
+    player->setCycleMode(mode);
+    return true;
+  }
+
+  bool LinkHealth::setCycleTimes(uint16_t cycles)
+  {
+    if (profile)
+      profile->desired.cycleTimes = cycles;
+    if (!canSend())
+      return false;
+    player->setCycleTimes(cycles);
+    return true;
+  }
+
+  bool LinkHealth::setPlayingDevice(device_t device)
+  {
+    if (profile)
+      profile->desired.device = device;
+    if (!canSend())
+      return false;
+    player->setPlayingDevice(device);
+    return true;
+  }
+}
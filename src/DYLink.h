@@ -0,0 +1,186 @@
+/**
+ * Keeps track of the health of the UART link with the module. When the module
+ * is unplugged or browns out, every query waits for the full timeout. After a
+ * few consecutive failures the link is considered down and queries fail right
+ * away, while the module is probed with a play state query on exponential
+ * backoff. While the link is up, failed queries (which are harmless to send
+ * again) are retried a few times. Settings sent through it are kept in a
+ * profile and sent again when the link recovers, as a brown-out of the module
+ * resets them.
+ */
+#ifndef DY_LINK_H
+#define DY_LINK_H
+#include <stdint.h>
+#include "DYPlayer.h"
+#include "DYProfile.h"
+
+// Consecutive failures before the link is considered down.
+#ifndef DY_LINK_FAILURES
+#define DY_LINK_FAILURES 3
+#endif
+
+// Times a failed query is sent again while the link is up.
+#ifndef DY_LINK_RETRIES
+#define DY_LINK_RETRIES 1
+#endif
+
+// Time between probes while the link is down, doubles after each failed probe.
+#ifndef DY_LINK_BACKOFF_MIN
+#define DY_LINK_BACKOFF_MIN 250
+#endif
+#ifndef DY_LINK_BACKOFF_MAX
+#define DY_LINK_BACKOFF_MAX 16000
+#endif
+
+// Times the profile is restored after the link recovers, until the module
+// confirms the storage device.
+#ifndef DY_LINK_RESTORES
+#define DY_LINK_RESTORES 2
+#endif
+
+namespace DY
+{
+  /**
+   * Counters kept by `DY::LinkHealth`.
+   */
+  typedef struct
+  {
+    uint32_t queries;   // Queries sent, including retries and probes.
+    uint32_t failures;  // Queries that failed.
+    uint32_t retries;   // Queries sent again after a failure.
+    uint32_t probes;    // Queries sent as a probe while the link was down.
+    uint32_t fastFails; // Queries and settings not sent while down.
+    uint16_t downs;     // Times the link went down.
+    uint16_t ups;       // Times the link recovered.
+    uint16_t restores;  // Times the profile was restored, including retries.
+  } link_counters_t;
+
+  class LinkHealth
+  {
+  public:
+    link_counters_t counters;
+
+    /**
+     * Called when the link goes down (false) or recovers (true), optional.
+     */
+    void (*onChange)(bool up);
+
+    /**
+     * Settings to restore when the link recovers, optional. The set methods
+     * keep the settings they send in `desired`, call `save()` to persist them.
+     * It's restored with `restore(false)`, as the module may or may not have
+     * lost its settings, up to `DY_LINK_RESTORES` times until the module
+     * confirms the storage device, before `onChange` is called.
+     */
+    Profile *profile;
+
+    /**
+     * @param player to monitor the link to, should implement `timeMs()`.
+     */
+    LinkHealth(DYPlayer *player);
+
+    /**
+     * @return Link is up (true) or down (false).
+     */
+    bool isUp();
+
+    /**
+     * Send a query, retried while the link is up, fails right away while the
+     * link is down, unless it's time to probe, then it's the probe.
+     * @param query A [`DY::Query` member](#typedef-enum-class-dyquery_t),
+     *              e.g. `DY::Query::SoundCount`.
+     * @param value pointer to keep the response value in.
+     * @return Response received (true), or failure (false).
+     */
+    bool query(query_t query, uint16_t *value);
+
+    /**
+     * Check the current play state, see `DY::DYPlayer::checkPlayState()`.
+     * @return `DY::PlayState::Fail` on failure, or when the link is down.
+     */
+    play_state_t checkPlayState();
+
+    /**
+     * Get the storage device, see `DY::DYPlayer::getPlayingDevice()`.
+     * @return `DY::Device::Fail` on failure, or when the link is down.
+     */
+    device_t getPlayingDevice();
+
+    /**
+     * Probe the module when the link is down and it's time to, call it from
+     * `loop()` to detect recovery without sending queries yourself.
+     */
+    void update();
+
+    /**
+     * Set the volume, see `DY::DYPlayer::setVolume()`, and keep it in the
+     * profile. Not sent while the link is down, the profile sends it when the
+     * link recovers.
+     * @param volume 0-30.
+     * @return Sent (true), or the link is down (false).
+     */
+    bool setVolume(uint8_t volume);
+
+    /**
+     * Set the equalizer, see `DY::DYPlayer::setEq()`, and keep it in the
+     * profile. Not sent while the link is down.
+     * @param eq A [`DY::Eq` member](#typedef-enum-class-dyeq_t).
+     * @return Sent (true), or the link is down (false).
+     */
+    bool setEq(eq_t eq);
+
+    /**
+     * Set the cycle mode, see `DY::DYPlayer::setCycleMode()`, and keep it in
+     * the profile. Not sent while the link is down.
+     * @param mode A [`DY::PlayMode` member](#typedef-enum-class-dyplaymode_t).
+     * @return Sent (true), or the link is down (false).
+     */
+    bool setCycleMode(play_mode_t mode);
+
+    /**
+     * Set the cycle times, see `DY::DYPlayer::setCycleTimes()`, and keep them
+     * in the profile. Not sent while the link is down.
+     * @param cycles Cycle times.
+     * @return Sent (true), or the link is down (false).
+     */
+    bool setCycleTimes(uint16_t cycles);
+
+    /**
+     * Set the storage device, see `DY::DYPlayer::setPlayingDevice()`, and
+     * keep it in the profile. Not sent while the link is down.
+     * @param device A [`DY::Device` member](#typedef-enum-class-dydevice_t).
+     * @return Sent (true), or the link is down (false).
+     */
+    bool setPlayingDevice(device_t device);
+
+  private:
+    DYPlayer *player;
+    bool up;
+    uint8_t consecutive;
+    uint16_t backoff;
+    uint32_t lastProbe;
+
+    /**
+     * Send a query once and update the link state.
+     */
+    bool attempt(query_t query, uint16_t *value);
+
+    /**
+     * Send a query as a probe if the backoff time has passed, fail right
+     * away otherwise.
+     */
+    bool probe(query_t query, uint16_t *value);
+
+    /**
+     * Count a command that isn't sent because the link is down.
+     * @return Link is up (true) or down (false).
+     */
+    bool canSend();
+
+    /**
+     * Restore the profile after the link recovered.
+     */
+    void restore();
+  };
+}
+#endif
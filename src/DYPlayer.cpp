@@ -6,7 +6,9 @@
  * There are some virtual methods that MUST be overridden (serialRead and
  * serialWrite) and one that you may override (begin)
  */
+#ifndef DY_NO_PATHS
 #include <ctype.h>
+#endif
 #include <string.h>
 #include "DYPlayer.h"
 
@@ -18,6 +20,88 @@ namespace DY
     serialWrite(buffer, 1);
   }
 
+  uint32_t DYPlayer::timeMs()
+  {
+    return 0;
+  }
+
+  void DYPlayer::delayMs(uint16_t ms)
+  {
+    (void)ms;
+  }
+
+  void DYPlayer::flushRx()
+  {
+  }
+
+  bool DYPlayer::isQuery(uint8_t command)
+  {
+    switch ((query_t)command)
+    {
+    case Query::PlayState:
+    case Query::PlayingDevice:
+    case Query::SoundCount:
+    case Query::PlayingSound:
+    case Query::FirstInDir:
+    case Query::SoundCountDir:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  void DYPlayer::transmit(uint8_t *buffer, uint8_t len)
+  {
+#ifndef DY_NO_BATCH
+    if (batch != 0)
+    {
+      batchSent += len;
+      if (batchLen + len > batchSize)
+      {
+        // Doesn't fit, send what we have, if it's still too big send it as is.
+        if (batchLen > 0)
+          serialWrite(batch, batchLen);
+        batchLen = 0;
+        if (len > batchSize)
+        {
+          serialWrite(buffer, len);
+          return;
+        }
+      }
+      memcpy(batch + batchLen, buffer, len);
+      batchLen += len;
+      return;
+    }
+#endif
+    // Single bytes (the CRC) go through the overridable single byte write.
+    if (len == 1)
+      serialWrite(buffer[0]);
+    else
+      serialWrite(buffer, len);
+  }
+
+#ifndef DY_NO_BATCH
+  void DYPlayer::beginBatch(uint8_t *buffer, uint8_t size)
+  {
+    batch = buffer;
+    batchSize = size;
+    batchLen = 0;
+    batchSent = 0;
+  }
+
+  uint16_t DYPlayer::endBatch()
+  {
+    if (batch != 0 && batchLen > 0)
+      serialWrite(batch, batchLen);
+    batch = 0;
+    batchLen = 0;
+#ifndef DY_NO_GAPS
+    lastSend = timeMs();
+#endif
+    return batchSent;
+  }
+#endif
+
   uint8_t inline DYPlayer::checksum(uint8_t *data, uint8_t len)
   {
     uint8_t sum = 0;
@@ -37,14 +121,22 @@ namespace DY
   void DYPlayer::sendCommand(uint8_t *data, uint8_t len)
   {
     uint8_t crc = checksum(data, len);
-    serialWrite(data, len);
-    serialWrite(crc);
+    sendCommand(data, len, crc);
   }
 
   void DYPlayer::sendCommand(uint8_t *data, uint8_t len, uint8_t crc)
   {
-    serialWrite(data, len);
-    serialWrite(crc);
+#ifndef DY_NO_GAPS
+    pace(data[1]);
+#endif
+    // The response must not be appended to what's left of an earlier one.
+    if (isQuery(data[1]))
+      flushRx();
+    transmit(data, len);
+    transmit(&crc, 1);
+#ifndef DY_NO_GAPS
+    lastSend = timeMs();
+#endif
   }
 
   bool DYPlayer::getResponse(uint8_t *buffer, uint8_t len)
@@ -59,6 +151,181 @@ namespace DY
     return false;
   }
 
+  void DYPlayer::beginQuery(query_t query)
+  {
+    uint8_t command[3] = {0xaa, 0x00, 0x00};
+    command[1] = (uint8_t)query;
+    sendCommand(command, 3);
+    pendingQuery = (uint8_t)query;
+    queryStart = timeMs();
+  }
+
+  bool DYPlayer::readQuery(uint8_t query, uint16_t *value)
+  {
+    // Play state and device are answered with 1 byte, the others with 2.
+    uint8_t len = 6;
+    if (query == (uint8_t)Query::PlayState ||
+        query == (uint8_t)Query::PlayingDevice)
+      len = 5;
+    uint8_t buffer[6];
+    if (getResponse(buffer, len))
+    {
+      *value = len == 5 ? buffer[3] : (buffer[3] << 8) | buffer[4];
+      return true;
+    }
+    return false;
+  }
+
+  query_state_t DYPlayer::pollQuery(uint16_t *value)
+  {
+    if (pendingQuery == 0)
+      return QueryState::Fail;
+    if (readQuery(pendingQuery, value))
+    {
+      pendingQuery = 0;
+      return QueryState::Done;
+    }
+    if (timeMs() - queryStart > DY_QUERY_TIMEOUT)
+    {
+      pendingQuery = 0;
+      flushRx();
+      return QueryState::Fail;
+    }
+    return QueryState::Pending;
+  }
+
+  bool DYPlayer::query(query_t query, uint16_t *value)
+  {
+    uint8_t command[3] = {0xaa, 0x00, 0x00};
+    command[1] = (uint8_t)query;
+    sendCommand(command, 3);
+    return readQuery((uint8_t)query, value);
+  }
+
+  void DYPlayer::sendFrame(uint8_t *frame, uint8_t len)
+  {
+    sendCommand(frame, len - 1, frame[len - 1]);
+  }
+
+#ifndef DY_NO_GAPS
+  void DYPlayer::setGap(gap_t gap, uint16_t ms)
+  {
+    gaps[(uint8_t)gap] = ms;
+  }
+
+  uint16_t DYPlayer::getGap(gap_t gap)
+  {
+    return gaps[(uint8_t)gap];
+  }
+
+  gap_t DYPlayer::gapOf(uint8_t command)
+  {
+    switch (command)
+    {
+    case 0x01:
+    case 0x0a:
+    case 0x0c:
+    case 0x0d:
+    case 0x11:
+    case 0x12:
+      return Gap::Query;
+    case 0x07:
+    case 0x16:
+    case 0x1b:
+    case 0x1f:
+      return Gap::Play;
+    case 0x08:
+    case 0x17:
+      return Gap::Path;
+    case 0x0b:
+      return Gap::Device;
+    case 0x13:
+    case 0x18:
+    case 0x19:
+    case 0x1a:
+      return Gap::Setting;
+    default:
+      return Gap::Control;
+    }
+  }
+
+  void DYPlayer::pace(uint8_t command)
+  {
+    uint16_t gap = gaps[lastGap];
+    lastGap = (uint8_t)gapOf(command);
+    if (gap == 0)
+      return;
+    uint32_t elapsed = timeMs() - lastSend;
+    if (elapsed >= gap)
+      return;
+#ifndef DY_NO_BATCH
+    // The batch would be sent after the wait otherwise.
+    if (batch != 0 && batchLen > 0)
+    {
+      serialWrite(batch, batchLen);
+      batchLen = 0;
+      lastSend = timeMs();
+      elapsed = 0;
+    }
+#endif
+    delayMs(gap - elapsed);
+  }
+
+  bool DYPlayer::gapHolds(gap_t gap, device_t device)
+  {
+    // The gaps measured so far keep the command itself from being dropped.
+    switch (gap)
+    {
+    case Gap::Control:
+      stop();
+      break;
+    case Gap::Play:
+      select(1);
+      break;
+    case Gap::Device:
+      setPlayingDevice(device);
+      break;
+    case Gap::Setting:
+      setEq(Eq::Normal);
+      break;
+    default:
+      checkPlayState();
+    }
+    uint16_t value;
+    return query(Query::PlayState, &value);
+  }
+
+  void DYPlayer::calibrateGaps()
+  {
+    device_t device = getPlayingDevice();
+    gap_t measure[5] = {Gap::Query, Gap::Control, Gap::Play, Gap::Device,
+                        Gap::Setting};
+    for (uint8_t i = 0; i < 5; i++)
+    {
+      gap_t gap = measure[i];
+      if (gap == Gap::Device && (uint8_t)device > (uint8_t)Device::Flash)
+        continue;
+      setGap(gap, 0);
+      if (gapHolds(gap, device) && gapHolds(gap, device))
+        continue;
+      // Binary search, a gap has to hold twice to rule out luck.
+      uint16_t low = 0;
+      uint16_t high = DY_GAP_MAX;
+      while (high - low > DY_GAP_RESOLUTION)
+      {
+        uint16_t mid = (low + high) / 2;
+        setGap(gap, mid);
+        if (gapHolds(gap, device) && gapHolds(gap, device))
+          high = mid;
+        else
+          low = mid;
+      }
+      setGap(gap, high);
+    }
+  }
+#endif
+
+#ifndef DY_NO_PATHS
   void DYPlayer::byPathCommand(uint8_t command, device_t device, char *path)
   {
     uint8_t len = strlen(path);
@@ -104,6 +371,7 @@ namespace DY
     delete[] _command;
 #endif
   }
+#endif
 
   play_state_t DYPlayer::checkPlayState()
   {
@@ -154,10 +422,12 @@ namespace DY
     command[4] = number & 0xff;
     sendCommand(command, 5);
   }
+#ifndef DY_NO_PATHS
   void DYPlayer::playSpecifiedDevicePath(device_t device, char *path)
   {
     byPathCommand(0x08, device, path);
   }
+#endif
 
   device_t DYPlayer::getPlayingDevice()
   {
@@ -259,25 +529,29 @@ namespace DY
     sendCommand(command, 3, 0xbf);
   }
 
+#ifndef DY_NO_INTERLUDE
   void DYPlayer::interludeSpecified(device_t device, uint16_t number)
   {
-    uint8_t command[6] = {0xaa, 0x0b, 0x03, 0x00, 0x00, 0x00};
+    uint8_t command[6] = {0xaa, 0x16, 0x03, 0x00, 0x00, 0x00};
     command[3] = (uint8_t)device;
     command[4] = number >> 8;
     command[5] = number & 0xff;
     sendCommand(command, 6);
   }
 
+#ifndef DY_NO_PATHS
   void DYPlayer::interludeSpecifiedDevicePath(device_t device, char *path)
   {
     byPathCommand(0x17, device, path);
   }
+#endif
 
   void DYPlayer::stopInterlude()
   {
     uint8_t command[3] = {0xaa, 0x10, 0x00};
     sendCommand(command, 3, 0xba);
   }
+#endif
 
   void DYPlayer::setCycleMode(play_mode_t mode)
   {
@@ -307,6 +581,7 @@ namespace DY
     command[4] = number & 0xff;
     sendCommand(command, 5);
   }
+#ifndef DY_NO_COMBINATION_PLAY
   void DYPlayer::combinationPlay(char *sounds[], uint8_t len)
   {
     if (len < 1)
@@ -318,16 +593,22 @@ namespace DY
     // later.
     uint8_t crc = checksum(command, 3);
     // Send the command and length already.
-    serialWrite(command, 3);
+#ifndef DY_NO_GAPS
+    pace(command[1]);
+#endif
+    transmit(command, 3);
     // Send each pair of chars containing the file name and add the values of
     // each char to the crc.
     for (uint8_t i = 0; i < len; i++)
     {
       crc += checksum((uint8_t *)sounds[i], 2);
-      serialWrite((uint8_t *)sounds[i], 2);
+      transmit((uint8_t *)sounds[i], 2);
     }
     // Lastly, write the crc value.
-    serialWrite(crc);
+    transmit(&crc, 1);
+#ifndef DY_NO_GAPS
+    lastSend = timeMs();
+#endif
   }
 
   void DYPlayer::endCombinationPlay()
@@ -335,4 +616,5 @@ namespace DY
     uint8_t command[3] = {0xaa, 0x1c, 0x00};
     sendCommand(command, 3, 0xc6);
   }
+#endif
 }
@@ -6,12 +6,39 @@
  * There are some virtual methods that MUST be overridden (serialRead and
  * serialWrite) and one that you may override (begin)
  */
+#ifndef DY_PLAYER_H
+#define DY_PLAYER_H
 #include <stdint.h>
 
 #ifndef DY_PATHS_IN_HEAP
 #define DY_PATH_LEN 40
 #endif
 
+// Feature switches, define any of these to leave out a group of commands and
+// save flash and RAM, see the readme, chapter: Memory use.
+// DY_NO_PATHS: `playSpecifiedDevicePath()` and
+//              `interludeSpecifiedDevicePath()`.
+// DY_NO_INTERLUDE: `interludeSpecified()`, `interludeSpecifiedDevicePath()`
+//                  and `stopInterlude()`.
+// DY_NO_COMBINATION_PLAY: `combinationPlay()` and `endCombinationPlay()`.
+// DY_NO_GAPS: `setGap()`, `getGap()` and `calibrateGaps()`.
+// DY_NO_BATCH: `beginBatch()` and `endBatch()`.
+
+// Longest gap between commands tried by `calibrateGaps()`, in milliseconds.
+#ifndef DY_GAP_MAX
+#define DY_GAP_MAX 1000
+#endif
+
+// Resolution of `calibrateGaps()`, in milliseconds.
+#ifndef DY_GAP_RESOLUTION
+#define DY_GAP_RESOLUTION 8
+#endif
+
+// Time to wait for the response to a query started by `beginQuery()`.
+#ifndef DY_QUERY_TIMEOUT
+#define DY_QUERY_TIMEOUT 1000
+#endif
+
 namespace DY
 {
   /**
@@ -87,6 +114,44 @@ namespace DY
     LastSound   // When navigating to the previous dir, play the last sound.
   } playDirSound_t;
 
+  /**
+   * Queries that can be sent by `DY::DYPlayer::beginQuery()`, they correspond
+   * to the get methods.
+   */
+  typedef enum class Query : uint8_t
+  {
+    PlayState = 0x01,     // `DY::DYPlayer::checkPlayState()`
+    PlayingDevice = 0x0a, // `DY::DYPlayer::getPlayingDevice()`
+    SoundCount = 0x0c,    // `DY::DYPlayer::getSoundCount()`
+    PlayingSound = 0x0d,  // `DY::DYPlayer::getPlayingSound()`
+    FirstInDir = 0x11,    // `DY::DYPlayer::getFirstInDir()`
+    SoundCountDir = 0x12  // `DY::DYPlayer::getSoundCountDir()`
+  } query_t;
+
+  /**
+   * State of a query started by `DY::DYPlayer::beginQuery()`.
+   */
+  typedef enum class QueryState : uint8_t
+  {
+    Pending, // The response has not (completely) arrived yet.
+    Done,    // The response arrived.
+    Fail     // No query was started, or it timed out.
+  } query_state_t;
+
+  /**
+   * Types of commands, the module drops commands that arrive too soon after
+   * the previous one, how soon depends on the type of the previous command.
+   */
+  typedef enum class Gap : uint8_t
+  {
+    Query,   // The get methods.
+    Control, // Play, pause, stop, previous, next, volume up/down, etc.
+    Play,    // Play, select or interlude a sound file by number.
+    Path,    // Play or interlude a sound file by path.
+    Device,  // Switch storage device.
+    Setting  // Volume, equalizer and cycle settings.
+  } gap_t;
+
   class DYPlayer
   {
   public:
@@ -113,6 +178,31 @@ namespace DY
      */
     virtual bool serialRead(uint8_t *buffer, uint8_t len) = 0;
 
+    /**
+     * Virtual method that may be overridden to return a clock in
+     * milliseconds, used for timing by features that need it, e.g.
+     * `DY::Profile::restore()`. The HALs included with the library do.
+     * @return Milliseconds since an arbitrary moment, `0` if there is no
+     *         clock.
+     */
+    virtual uint32_t timeMs();
+
+    /**
+     * Virtual method that may be overridden to wait a while, used to keep
+     * the gaps between commands (see `DY::DYPlayer::setGap()`). The HALs
+     * included with the library do.
+     * @param ms Milliseconds to wait.
+     */
+    virtual void delayMs(uint16_t ms);
+
+    /**
+     * Virtual method that may be overridden to discard received bytes, e.g.
+     * what arrived of a response that timed out, so the next response isn't
+     * appended to them. Called before a query is sent and when
+     * `pollQuery()` times out. The HALs included with the library do.
+     */
+    virtual void flushRx();
+
     /**
      * Check the current play state can, be called at any time.
      * @return Play status: A [`DY::PlayState`](#typedef-enum-class-dyplay_state_t),
@@ -151,6 +241,7 @@ namespace DY
      */
     void playSpecified(uint16_t number);
 
+#ifndef DY_NO_PATHS
     /**
      * Play a sound file by device and path.
      * Path may consist of up to 2 nested directories of 8 bytes long and a
@@ -163,6 +254,7 @@ namespace DY
      * @param path pointer to the path of the file (asbsolute).
      */
     void playSpecifiedDevicePath(device_t device, char *path);
+#endif
 
     /**
      * Get the storage device that is currently used for playing sound files.
@@ -230,6 +322,7 @@ namespace DY
      */
     void volumeDecrease();
 
+#ifndef DY_NO_INTERLUDE
     /**
      * Play an interlude file by device and number, number sent as 2 bytes.
      * Note from the manual: "Music interlude" only has level 1. Continuous
@@ -242,6 +335,7 @@ namespace DY
      */
     void interludeSpecified(device_t device, uint16_t number);
 
+#ifndef DY_NO_PATHS
     /**
      * Play an interlude by device and path.
      * Note from the manual: "Music interlude" only has level 1. Continuous
@@ -259,6 +353,7 @@ namespace DY
      * @param path pointer to the path of the file (asbsolute).
      */
     void interludeSpecifiedDevicePath(device_t device, char *path);
+#endif
 
     /**
      * Stop the interlude and continue playing.
@@ -266,6 +361,7 @@ namespace DY
      * active.
      */
     void stopInterlude();
+#endif
 
     /**
      * Sets the cycle mode.
@@ -295,6 +391,7 @@ namespace DY
      */
     void select(uint16_t number);
 
+#ifndef DY_NO_COMBINATION_PLAY
     /**
      * Combination play allows you to make a playlist of multiple sound files.
      *
@@ -325,8 +422,166 @@ namespace DY
      * End combination play.
      */
     void endCombinationPlay();
+#endif
+
+#ifndef DY_NO_BATCH
+    /**
+     * Collect the commands that follow in a buffer instead of sending them
+     * one at a time, so they can be sent in a single burst by
+     * `DY::DYPlayer::endBatch()`. If the buffer is full, it is sent and
+     * collecting continues.
+     * NOTE: Get methods can't be batched, they need the response right away,
+     * so don't use them until the batch is ended.
+     * @param buffer pointer to keep the commands in.
+     * @param size of buffer.
+     */
+    void beginBatch(uint8_t *buffer, uint8_t size);
+
+    /**
+     * Send the commands collected since `DY::DYPlayer::beginBatch()` in a
+     * single write and return to sending commands right away.
+     * @return number of bytes sent by the batch.
+     */
+    uint16_t endBatch();
+#endif
+
+    /**
+     * Send a query without waiting for the response, so the program can do
+     * other things meanwhile. Check for the response with
+     * `DY::DYPlayer::pollQuery()`. This is most useful with a HAL that
+     * doesn't wait for data in `serialRead()`, e.g. the Arduino HAL with
+     * `DY::Player::setReadBudget()`.
+     * @param query A [`DY::Query` member](#typedef-enum-class-dyquery_t),
+     *              e.g. `DY::Query::PlayState`.
+     */
+    void beginQuery(query_t query);
+
+    /**
+     * Check whether the response to the query started by
+     * `DY::DYPlayer::beginQuery()` arrived. Times out after
+     * `DY_QUERY_TIMEOUT` milliseconds, as measured by `timeMs()`.
+     * @param value pointer to keep the response value in, the same value
+     *              the corresponding get method would return.
+     * @return A [`DY::QueryState`](#typedef-enum-class-dyquery_state_t),
+     *         e.g. `DY::QueryState::Done`.
+     */
+    query_state_t pollQuery(uint16_t *value);
+
+    /**
+     * Send a query and wait for the response, like the get methods do, but
+     * tells a failure apart from a response, e.g. a sound count of `0`.
+     * @param query A [`DY::Query` member](#typedef-enum-class-dyquery_t),
+     *              e.g. `DY::Query::SoundCount`.
+     * @param value pointer to keep the response value in, the same value
+     *              the corresponding get method would return.
+     * @return Response received (true), or communication failure (false).
+     */
+    bool query(query_t query, uint16_t *value);
+
+    /**
+     * Send a complete frame that was encoded beforehand, e.g. by a script
+     * compiler, keeping the gaps and batches like any other command.
+     * @param frame pointer to the frame, from `0xaa` up to and including the
+     *              CRC.
+     * @param len of frame.
+     */
+    void sendFrame(uint8_t *frame, uint8_t len);
+
+#ifndef DY_NO_GAPS
+    /**
+     * Set the minimum time between a type of command and the next command,
+     * the library waits (using `delayMs()`) when needed before sending the
+     * next command. All gaps are `0` by default.
+     * @param gap A [`DY::Gap` member](#typedef-enum-class-dygap_t), the type
+     *            of command, e.g. `DY::Gap::Device`.
+     * @param ms Milliseconds between this type of command and the next.
+     */
+    void setGap(gap_t gap, uint16_t ms);
+
+    /**
+     * Get the minimum time between a type of command and the next command.
+     * @param gap A [`DY::Gap` member](#typedef-enum-class-dygap_t), the type
+     *            of command, e.g. `DY::Gap::Device`.
+     * @return Milliseconds between this type of command and the next.
+     */
+    uint16_t getGap(gap_t gap);
+
+    /**
+     * Measure the shortest gap the module tolerates after each type of
+     * command, by sending a command of that type followed by a query and
+     * searching for the shortest gap after which the query is answered.
+     * Sets the gaps, store them with `getGap()` to skip this next time.
+     *
+     * This sends `stop()`, `select(1)`, `setEq(DY::Eq::Normal)` and switches
+     * to the current device. Gaps after paths are not measured as it would
+     * play sounds, set those with `setGap()`. Takes a few seconds, every
+     * dropped query adds the time the HAL waits for a response.
+     */
+    void calibrateGaps();
+#endif
+
+  protected:
+    /**
+     * @param command byte of a command.
+     * @return The module responds to the command (true), or not (false).
+     */
+    static bool isQuery(uint8_t command);
 
   private:
+#ifndef DY_NO_GAPS
+    uint16_t gaps[6] = {0, 0, 0, 0, 0, 0};
+    uint8_t lastGap = 0;
+    uint32_t lastSend = 0;
+#endif
+    uint8_t pendingQuery = 0;
+    uint32_t queryStart = 0;
+#ifndef DY_NO_BATCH
+    uint8_t *batch = 0;
+    uint8_t batchSize = 0;
+    uint8_t batchLen = 0;
+    uint16_t batchSent = 0;
+#endif
+
+    /**
+     * Send bytes to the module, or add them to the batch if one was started.
+     * @param buffer pointer to bytes to send to the module.
+     * @param len of buffer.
+     */
+    void transmit(uint8_t *buffer, uint8_t len);
+
+    /**
+     * Read the response to a query.
+     * @param query command byte of the query.
+     * @param value pointer to keep the response value in.
+     * @return False on communication failure.
+     */
+    bool readQuery(uint8_t query, uint16_t *value);
+
+#ifndef DY_NO_GAPS
+    /**
+     * Get the type of a command, see `DY::Gap`.
+     * @param command byte of the command.
+     * @return The type of command.
+     */
+    gap_t gapOf(uint8_t command);
+
+    /**
+     * Wait for the gap after the previous command before sending a command.
+     * If commands are batched, the batch is sent first.
+     * @param command byte of the command that is about to be sent.
+     */
+    void pace(uint8_t command);
+
+    /**
+     * Send a command of a type and check that a query right after the gap
+     * of that type is answered.
+     * @param gap The type of command.
+     * @param device to switch to for `DY::Gap::Device`.
+     * @return Query was answered (true) or not (false).
+     */
+    bool gapHolds(gap_t gap, device_t device);
+#endif
+
     /**
      * Calculate the sum of all bytes in a buffer as a simple "CRC".
      * @param data pointer to bytes to calculate the CRC for.
@@ -368,6 +623,7 @@ namespace DY
      */
     bool getResponse(uint8_t *buffer, uint8_t len);
 
+#ifndef DY_NO_PATHS
     /**
      * Send command with converted paths to  weird format required by the
      * modules.
@@ -384,5 +640,7 @@ namespace DY
      * @param path of the file (asbsolute).
      */
     void byPathCommand(uint8_t command, device_t device, char *path);
+#endif
   };
 }
+#endif
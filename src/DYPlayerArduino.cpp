@@ -48,16 +48,161 @@ namespace DY
   }
   void Player::serialWrite(uint8_t *buffer, uint8_t len)
   {
+#ifdef HAS_SOFTWARE_SERIAL
+    // Start listening before sending a query, the module may respond before
+    // the response is read.
+    if (listenOnDemand && len > 1 && buffer[0] == 0xaa && isQuery(buffer[1]))
+    {
+      ((SoftwareSerial *)port)->listen();
+      listening = true;
+    }
+#endif
     port->write(buffer, len);
+#ifdef HAS_SOFTWARE_SERIAL
+    if (listening)
+      listenStart = millis();
+#endif
   }
   bool Player::serialRead(uint8_t *buffer, uint8_t len)
   {
-    // Serial.setTimeout(1000); // Default timeout 1000ms.
-    if (port->readBytes(buffer, len) > 0)
+#ifdef HAS_SOFTWARE_SERIAL
+    if (!listenOnDemand)
+      return readBytes(buffer, len);
+    if (!listening)
+      return false;
+    // Response time at 9600 baud, 10 bits per byte, rounded up.
+    uint32_t window = DY_LISTEN_MARGIN + (len * 10000UL + 9599) / 9600;
+    bool done;
+    if (readBudget > 0)
+    {
+      done = readBytes(buffer, len);
+    }
+    else
+    {
+      // Wait until the window since sending the query closes. The Stream
+      // timeout (left as set by the user) would apply to each byte.
+      uint8_t received = 0;
+      while (received < len && millis() - listenStart < window)
+      {
+        if (port->available() > 0)
+          buffer[received++] = port->read();
+      }
+      done = received == len;
+    }
+    if (done || millis() - listenStart >= window)
     {
-      return true;
+      ((SoftwareSerial *)port)->stopListening();
+      listening = false;
     }
+    return done;
+#else
+    return readBytes(buffer, len);
+#endif
+  }
+  bool Player::readBytes(uint8_t *buffer, uint8_t len)
+  {
+    if (readBudget == 0)
+    {
+      // Serial.setTimeout(1000); // Default timeout 1000ms.
+      if (port->readBytes(buffer, len) > 0)
+      {
+        return true;
+      }
+      return false;
+    }
+    if (len > DY_RX_BUFFER_LEN)
+      return false;
+    uint32_t start = micros();
+    do
+    {
+      while (rxLen < len && port->available() > 0)
+      {
+        uint8_t byte = port->read();
+        // Responses start with 0xaa, skip the rest of a late response.
+        if (rxLen == 0 && byte != 0xaa)
+          continue;
+        rx[rxLen++] = byte;
+      }
+      if (rxLen == len)
+      {
+        memcpy(buffer, rx, len);
+        rxLen = 0;
+        return true;
+      }
+    } while (micros() - start < readBudget);
     return false;
   }
+  void Player::setReadBudget(uint32_t us)
+  {
+    readBudget = us;
+    rxLen = 0;
+  }
+  void Player::flushRx()
+  {
+    rxLen = 0;
+    while (port->available() > 0)
+      port->read();
+  }
+#ifdef HAS_SOFTWARE_SERIAL
+  void Player::setListenOnDemand(bool enable)
+  {
+    if (!isSoftSerial)
+      return;
+    listenOnDemand = enable;
+    listening = false;
+    if (enable)
+      ((SoftwareSerial *)port)->stopListening();
+    else
+      ((SoftwareSerial *)port)->listen();
+  }
+#endif
+  uint32_t Player::timeMs()
+  {
+    return millis();
+  }
+  void Player::delayMs(uint16_t ms)
+  {
+    delay(ms);
+  }
+
+#ifdef HAS_EEPROM
+  EepromStorage::EepromStorage(int address)
+  {
+    this->address = address;
+  }
+  bool EepromStorage::read(uint8_t *buffer, uint16_t len)
+  {
+#if defined(ESP8266) || defined(ESP32)
+    // EEPROM is emulated in flash on Espressif boards, it needs to be sized.
+    EEPROM.begin(address + len);
+#endif
+    if (address + len > (int)EEPROM.length())
+      return false;
+    for (uint16_t i = 0; i < len; i++)
+    {
+      buffer[i] = EEPROM.read(address + i);
+    }
+    return true;
+  }
+  bool EepromStorage::write(uint8_t *buffer, uint16_t len)
+  {
+#if defined(ESP8266) || defined(ESP32)
+    EEPROM.begin(address + len);
+#endif
+    if (address + len > (int)EEPROM.length())
+      return false;
+    for (uint16_t i = 0; i < len; i++)
+    {
+      // Only write changed bytes, EEPROM cells wear out.
+      if (EEPROM.read(address + i) != buffer[i])
+        EEPROM.write(address + i, buffer[i]);
+    }
+#if defined(ESP8266) || defined(ESP32)
+    return EEPROM.commit();
+#else
+    return true;
+#endif
+  }
+#endif
 }
 #endif
@@ -1,6 +1,7 @@
 #ifdef ARDUINO
 #include <Arduino.h>
 #include "DYPlayer.h"
+#include "DYStorage.h"
 
 #ifdef __has_include
 #if __has_include("SoftwareSerial.h")
@@ -14,11 +15,31 @@
 #endif
 #endif
 
+#ifdef __has_include
+#if __has_include("EEPROM.h")
+#define HAS_EEPROM
+#endif
+#endif
+
 // Include SoftwareSerial for Arduino boards that probably support it.
 #ifdef HAS_SOFTWARE_SERIAL
 #include "SoftwareSerial.h"
 #endif
 
+#ifdef HAS_EEPROM
+#include "EEPROM.h"
+#endif
+
+// Time the module may take to start responding, added to the listen window.
+#ifndef DY_LISTEN_MARGIN
+#define DY_LISTEN_MARGIN 100
+#endif
+
+// Receive buffer for reads with a budget, fits the longest response.
+#ifndef DY_RX_BUFFER_LEN
+#define DY_RX_BUFFER_LEN 6
+#endif
+
 namespace DY
 {
   class Player : public DYPlayer
@@ -37,6 +58,48 @@ namespace DY
     void begin();
     void serialWrite(uint8_t *buffer, uint8_t len);
     bool serialRead(uint8_t *buffer, uint8_t len);
+    uint32_t timeMs();
+    void delayMs(uint16_t ms);
+    void flushRx();
+    /**
+     * Limit the time `serialRead()` may take, instead of waiting for the
+     * stream timeout. Received bytes are kept until the response is
+     * complete, use `beginQuery()` and `pollQuery()` to get responses.
+     * @param us Microseconds, `0` (default) waits for the stream timeout.
+     */
+    void setReadBudget(uint32_t us);
+#ifdef HAS_SOFTWARE_SERIAL
+    /**
+     * Only listen on the `SoftwareSerial` port while a response is expected,
+     * for as long as the response takes at 9600 baud plus
+     * `DY_LISTEN_MARGIN` milliseconds. Saves the CPU time spent receiving
+     * and frees the port for other `SoftwareSerial` ports to listen on.
+     * @param enable Listen on demand (true), or always (false, default).
+     */
+    void setListenOnDemand(bool enable);
+#endif
+
+  private:
+    uint32_t readBudget = 0;
+    uint8_t rx[DY_RX_BUFFER_LEN];
+    uint8_t rxLen = 0;
+#ifdef HAS_SOFTWARE_SERIAL
+    bool listenOnDemand = false;
+    bool listening = false;
+    uint32_t listenStart = 0;
+#endif
+    bool readBytes(uint8_t *buffer, uint8_t len);
   };
+
+#ifdef HAS_EEPROM
+  class EepromStorage : public Storage
+  {
+  public:
+    int address;
+    EepromStorage(int address);
+    bool read(uint8_t *buffer, uint16_t len);
+    bool write(uint8_t *buffer, uint16_t len);
+  };
+#endif
 }
 #endif
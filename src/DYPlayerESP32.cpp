@@ -8,11 +8,17 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <esp_log.h>
+#include "esp_timer.h"
 //#include "esp_system.h"
 #include "driver/uart.h"
+#include "nvs.h"
+#include <string.h>
 
 #define BUFFER_SIZE_RX 256
 #define BUFFER_SIZE_TX 256
+// Time a byte takes on the wire at 9600 baud, 10 bits.
+#define BYTE_US 1042
+#define NVS_NAMESPACE "dyplayer"
 
 namespace DY
 {
@@ -39,12 +45,45 @@ namespace DY
         &uart_queue,
         0));
     this->uart_num = uart_num;
+    memset(&txStats, 0, sizeof(txStats));
   }
   void Player::serialWrite(uint8_t *buffer, uint8_t len)
   {
-    // Blocking call, waits for space in hardware FIFO buffer.
-    // Commands are short so this shouldn't be an issue.
-    uart_write_bytes(uart_num, (char *)buffer, len);
+    int64_t start = esp_timer_get_time();
+    // Copied to the TX buffer, only waits when it's full (see txFree()).
+    uart_write_bytes(uart_num, (const char *)buffer, len);
+    int64_t now = esp_timer_get_time();
+    txEnd = (txEnd > start ? txEnd : start) + len * BYTE_US;
+    uint32_t blocked = now - start;
+    txStats.writes++;
+    txStats.bytes += len;
+    txStats.blockedUs += blocked;
+    if (blocked > txStats.maxBlockedUs)
+      txStats.maxBlockedUs = blocked;
+  }
+  void Player::flushRx()
+  {
+    uart_flush_input(uart_num);
+  }
+  uint16_t Player::txFree()
+  {
+    int64_t left = txEnd - esp_timer_get_time();
+    uint32_t queued = left > 0 ? (left + BYTE_US - 1) / BYTE_US : 0;
+    // The hardware FIFO holds some more, leave it as a margin.
+    return queued >= BUFFER_SIZE_TX ? 0 : BUFFER_SIZE_TX - queued;
+  }
+  bool Player::txDone()
+  {
+    return uart_wait_tx_done(uart_num, 0) == ESP_OK;
+  }
+  bool Player::waitTxDone(uint16_t ms)
+  {
+    TickType_t ticks = (ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS;
+    return uart_wait_tx_done(uart_num, ticks) == ESP_OK;
+  }
+  int64_t Player::txDoneAt()
+  {
+    return txEnd;
   }
   bool Player::serialRead(uint8_t *buffer, uint8_t len)
   {
@@ -70,6 +109,42 @@ namespace DY
     }
     return false;
   }
+  uint32_t Player::timeMs()
+  {
+    return esp_timer_get_time() / 1000;
+  }
+  void Player::delayMs(uint16_t ms)
+  {
+    // Round up, waiting too short could get the next command dropped.
+    vTaskDelay((ms + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS);
+  }
+
+  // NOTE: The application should call `nvs_flash_init()` before use.
+  NvsStorage::NvsStorage(const char *key)
+  {
+    this->key = key;
+  }
+  bool NvsStorage::read(uint8_t *buffer, uint16_t len)
+  {
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+      return false;
+    size_t length = len;
+    esp_err_t err = nvs_get_blob(handle, key, buffer, &length);
+    nvs_close(handle);
+    return err == ESP_OK && length == len;
+  }
+  bool NvsStorage::write(uint8_t *buffer, uint16_t len)
+  {
+    nvs_handle_t handle;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK)
+      return false;
+    esp_err_t err = nvs_set_blob(handle, key, buffer, len);
+    if (err == ESP_OK)
+      err = nvs_commit(handle);
+    nvs_close(handle);
+    return err == ESP_OK;
+  }
 }
 #endif
 #endif
@@ -1,15 +1,80 @@
 #ifdef ESP_PLATFORM
 #include "driver/uart.h"
 #include "DYPlayer.h"
+#include "DYStorage.h"
 namespace DY
 {
+  /**
+   * Counters of the writes to the UART, kept by `DY::Player`.
+   */
+  typedef struct
+  {
+    uint32_t writes;       // Calls to serialWrite().
+    uint32_t bytes;        // Bytes written.
+    uint32_t blockedUs;    // Time spent in serialWrite().
+    uint32_t maxBlockedUs; // Longest single serialWrite().
+  } tx_stats_t;
+
   class Player : public DYPlayer
   {
   public:
     Player(uart_port_t uart_num, uint8_t pin_rx, uint8_t pin_tx);
     void serialWrite(uint8_t *buffer, uint8_t len);
     bool serialRead(uint8_t *buffer, uint8_t len);
+    uint32_t timeMs();
+    void delayMs(uint16_t ms);
+    void flushRx();
     uart_port_t uart_num;
+    tx_stats_t txStats;
+
+    /**
+     * Bytes that can be written without waiting for room in the TX buffer,
+     * estimated from the bytes written and the time they take at 9600 baud.
+     * Check it before a burst of commands to never block.
+     * @return Free bytes.
+     */
+    uint16_t txFree();
+
+    /**
+     * Whether the TX buffer has drained, not whether a specific command has
+     * left the wire: false while anything written later is still queued. Use
+     * txDoneAt() for a single command.
+     * @return Everything written has left the wire (true), or is still being
+     *         sent (false).
+     */
+    bool txDone();
+
+    /**
+     * Wait until everything written has left the wire, e.g. to send a time
+     * critical command right after. Woken by the UART's TX done interrupt,
+     * so it returns as soon as the last bit is out. Like txDone(), it waits
+     * for the TX buffer to drain, including commands written after the one
+     * of interest.
+     * @param ms Milliseconds to wait at most.
+     * @return Done (true), or timed out (false).
+     */
+    bool waitTxDone(uint16_t ms);
+
+    /**
+     * The time everything written will have left the wire, estimated at 9600
+     * baud, to schedule the next command (e.g. with an `esp_timer`) instead
+     * of waiting. Read right after sending a command, it's the time that
+     * command will have left the wire, later commands don't change it.
+     * @return Microseconds, on the `esp_timer_get_time()` clock.
+     */
+    int64_t txDoneAt();
+
+  private:
+    int64_t txEnd = 0;
+  };
+
+  class NvsStorage : public Storage
+  {
+  public:
+    NvsStorage(const char *key);
+    bool read(uint8_t *buffer, uint16_t len);
+    bool write(uint8_t *buffer, uint16_t len);
+    const char *key;
   };
 }
 #endif
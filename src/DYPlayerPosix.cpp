@@ -0,0 +1,104 @@
+/*
+  This is a hardware abstraction layer, it tells the library how to use a
+  serial port on Linux and other unix like systems, e.g. /dev/ttyUSB0.
+*/
+#if defined(__unix__) && !defined(ARDUINO) && !defined(ESP_PLATFORM)
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "DYPlayerPosix.h"
+
+namespace DY
+{
+  Player::Player(const char *device)
+  {
+    fd = open(device, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0)
+      return;
+    struct termios tty;
+    tcgetattr(fd, &tty);
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, B9600);
+    cfsetospeed(&tty, B9600);
+    tty.c_cflag |= CLOCAL | CREAD;
+    tty.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tcsetattr(fd, TCSANOW, &tty);
+    tcflush(fd, TCIOFLUSH);
+  }
+  Player::~Player()
+  {
+    if (fd >= 0)
+      close(fd);
+  }
+  void Player::serialWrite(uint8_t *buffer, uint8_t len)
+  {
+    uint8_t written = 0;
+    while (fd >= 0 && written < len)
+    {
+      ssize_t n = write(fd, buffer + written, len - written);
+      if (n > 0)
+      {
+        written += n;
+        continue;
+      }
+      // Output buffer full, wait until there is room.
+      struct pollfd pfd = {fd, POLLOUT, 0};
+      if (poll(&pfd, 1, 1000) <= 0)
+        return;
+    }
+  }
+  bool Player::serialRead(uint8_t *buffer, uint8_t len)
+  {
+    if (fd < 0 || len > DY_RX_BUFFER_LEN)
+      return false;
+    uint32_t start = timeMs();
+    while (true)
+    {
+      uint8_t byte;
+      while (rxLen < len && read(fd, &byte, 1) == 1)
+      {
+        // Responses start with 0xaa, skip the rest of a late response.
+        if (rxLen == 0 && byte != 0xaa)
+          continue;
+        rx[rxLen++] = byte;
+      }
+      if (rxLen == len)
+      {
+        memcpy(buffer, rx, len);
+        rxLen = 0;
+        return true;
+      }
+      int32_t left = readTimeout - (int32_t)(timeMs() - start);
+      if (left <= 0)
+        return false;
+      struct pollfd pfd = {fd, POLLIN, 0};
+      poll(&pfd, 1, left);
+    }
+  }
+  uint32_t Player::timeMs()
+  {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000 + now.tv_nsec / 1000000;
+  }
+  void Player::delayMs(uint16_t ms)
+  {
+    struct timespec wait = {ms / 1000, (ms % 1000) * 1000000L};
+    nanosleep(&wait, NULL);
+  }
+  void Player::flushRx()
+  {
+    rxLen = 0;
+    if (fd >= 0)
+      tcflush(fd, TCIFLUSH);
+  }
+  void Player::setReadTimeout(uint16_t ms)
+  {
+    readTimeout = ms;
+    rxLen = 0;
+  }
+}
+#endif
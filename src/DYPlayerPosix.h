@@ -0,0 +1,36 @@
+#if defined(__unix__) && !defined(ARDUINO) && !defined(ESP_PLATFORM)
+#include "DYPlayer.h"
+
+// Receive buffer, fits the longest response.
+#ifndef DY_RX_BUFFER_LEN
+#define DY_RX_BUFFER_LEN 6
+#endif
+
+namespace DY
+{
+  class Player : public DYPlayer
+  {
+  public:
+    int fd;
+    Player(const char *device);
+    ~Player();
+    void serialWrite(uint8_t *buffer, uint8_t len);
+    bool serialRead(uint8_t *buffer, uint8_t len);
+    uint32_t timeMs();
+    void delayMs(uint16_t ms);
+    void flushRx();
+    /**
+     * Set how long `serialRead()` waits for a response. With `0` it never
+     * waits, received bytes are kept until the response is complete, use
+     * `beginQuery()` and `pollQuery()` to get responses.
+     * @param ms Milliseconds, default `1000`.
+     */
+    void setReadTimeout(uint16_t ms);
+
+  private:
+    uint16_t readTimeout = 1000;
+    uint8_t rx[DY_RX_BUFFER_LEN];
+    uint8_t rxLen = 0;
+  };
+}
+#endif
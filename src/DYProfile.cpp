@@ -0,0 +1,112 @@
+/**
+ * The desired settings of the module, see DYProfile.h.
+ */
+#include "DYProfile.h"
+
+// Longest burst: volume, eq and cycle mode are 5 bytes, cycle times 6.
+#define PROFILE_BATCH_SIZE 21
+// Queries to confirm the device switch, the module may drop the first one
+// while it switches if no device gap is set.
+#define PROFILE_CONFIRM_TRIES 2
+// Queries without arguments are 3 bytes and the CRC.
+#define QUERY_LEN 4
+
+namespace DY
+{
+  // Settings of the module after power on.
+  static const profile_t defaults = {
+      20, Eq::Normal, PlayMode::OneOff, 0, Device::NoDevice};
+
+  Profile::Profile(DYPlayer *player, Storage *storage)
+  {
+    this->player = player;
+    this->storage = storage;
+    this->desired = defaults;
+    snapshot.reset();
+  }
+
+  bool Profile::load()
+  {
+    if (!snapshot.load(storage))
+      return false;
+    desired = snapshot.data;
+    return true;
+  }
+
+  bool Profile::save()
+  {
+    snapshot.data = desired;
+    return snapshot.save(storage);
+  }
+
+  restore_result_t Profile::restore(bool moduleReset)
+  {
+    restore_result_t result = {0, 0, 0, false};
+    uint32_t start = player->timeMs();
+
+    device_t current = player->getPlayingDevice();
+    result.bytes += QUERY_LEN;
+    // Either it's already right, or any device will do, as long as the
+    // module responds.
+    result.verified = current != Device::Fail;
+    bool switchDevice = (uint8_t)desired.device <= (uint8_t)Device::Flash &&
+                        current != desired.device;
+    if (switchDevice)
+    {
+      // On its own and confirmed before the settings, the module drops
+      // commands while it switches, settings may also apply per device.
+      // The query waits for the device gap, if it's set.
+      player->setPlayingDevice(desired.device);
+      result.commands++;
+      result.bytes += 5;
+      current = Device::Fail;
+      for (uint8_t i = 0; i < PROFILE_CONFIRM_TRIES && current == Device::Fail;
+           i++)
+      {
+        current = player->getPlayingDevice();
+        result.bytes += QUERY_LEN;
+      }
+      result.verified = current == desired.device;
+    }
+
+#ifndef DY_NO_BATCH
+    uint8_t buffer[PROFILE_BATCH_SIZE];
+    player->beginBatch(buffer, PROFILE_BATCH_SIZE);
+#endif
+    if (!moduleReset || desired.volume != defaults.volume)
+    {
+      player->setVolume(desired.volume);
+      result.commands++;
+    }
+    if (!moduleReset || desired.eq != defaults.eq)
+    {
+      player->setEq(desired.eq);
+      result.commands++;
+    }
+    if (!moduleReset || desired.cycleMode != defaults.cycleMode)
+    {
+      player->setCycleMode(desired.cycleMode);
+      result.commands++;
+    }
+    // Cycle times only apply to the repeat modes.
+    bool cycleTimes =
+        (!moduleReset || desired.cycleTimes != defaults.cycleTimes) &&
+        (desired.cycleMode == PlayMode::Repeat ||
+         desired.cycleMode == PlayMode::RepeatOne ||
+         desired.cycleMode == PlayMode::RepeatDir);
+    if (cycleTimes)
+    {
+      player->setCycleTimes(desired.cycleTimes);
+      result.commands++;
+    }
+#ifndef DY_NO_BATCH
+    result.bytes += player->endBatch();
+#else
+    // Sent one at a time, all 5 bytes except cycle times.
+    result.bytes += (result.commands - (switchDevice ? 1 : 0)) * 5 +
+                    (cycleTimes ? 1 : 0);
+#endif
+    result.timeMs = player->timeMs() - start;
+    return result;
+  }
+}
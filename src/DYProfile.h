@@ -0,0 +1,93 @@
+/**
+ * The desired settings of the module, kept in persistent storage, so they can
+ * be restored after a power cycle with as few commands as possible.
+ */
+#ifndef DY_PROFILE_H
+#define DY_PROFILE_H
+#include <stdint.h>
+#include "DYPlayer.h"
+#include "DYStorage.h"
+
+#define DY_PROFILE_MAGIC 0x50 // P
+#define DY_PROFILE_VERSION 1
+
+namespace DY
+{
+  /**
+   * Settings of the module to restore.
+   */
+  typedef struct
+  {
+    uint8_t volume;
+    eq_t eq;
+    play_mode_t cycleMode;
+    uint16_t cycleTimes;
+    device_t device; // `DY::Device::NoDevice` leaves it to the module.
+  } profile_t;
+
+  /**
+   * What restoring the profile took.
+   */
+  typedef struct
+  {
+    uint8_t commands;  // Amount of commands sent.
+    uint16_t bytes;    // Amount of bytes sent, including queries.
+    uint32_t timeMs;   // Time until the module was ready (see `timeMs()`).
+    bool verified;     // The module answered on the desired device.
+  } restore_result_t;
+
+  class Profile
+  {
+  public:
+    /**
+     * The settings to restore, change them and call `save()` to keep them.
+     * Initially the settings of the module after power on.
+     */
+    profile_t desired;
+
+    /**
+     * @param player to restore the settings of.
+     * @param storage to persist the profile in.
+     */
+    Profile(DYPlayer *player, Storage *storage);
+
+    /**
+     * Load the profile from storage, keeps the defaults on failure.
+     * @return Successful load (true), failure or invalid data (false).
+     */
+    bool load();
+
+    /**
+     * Save the profile to storage.
+     * @return Successful save (true), failure (false).
+     */
+    bool save();
+
+    /**
+     * Send only the commands needed to get the module to the desired state.
+     *
+     * The storage device is queried and only switched if it differs. The
+     * switch is sent on its own and confirmed by querying the device again,
+     * after the device gap if it's set (see `DY::DYPlayer::setGap()`), the
+     * query is tried twice as the module may drop the first while it
+     * switches. The settings follow in a single burst.
+     *
+     * Volume, equalizer and cycle settings can't be queried, so they are not
+     * confirmed. After a power cycle of the module they are sent if they
+     * differ from its defaults, otherwise (e.g. only the MCU was reset, the
+     * module kept its settings) they are always sent. Cycle times are only
+     * sent for the repeat modes that use them.
+     * @param moduleReset The module was powered on with the MCU (true,
+     *        default), or its state is unknown (false).
+     * @return What it took, see `DY::restore_result_t`.
+     */
+    restore_result_t restore(bool moduleReset = true);
+
+  private:
+    DYPlayer *player;
+    Storage *storage;
+
+    Snapshot<profile_t, DY_PROFILE_MAGIC, DY_PROFILE_VERSION> snapshot;
+  };
+}
+#endif
@@ -0,0 +1,253 @@
+/**
+ * Sound script interpreter, see DYScript.h.
+ */
+#include <string.h>
+#include "DYScript.h"
+
+namespace DY
+{
+  // What the script is doing.
+  enum
+  {
+    Done,
+    Running,
+    Sleeping, // Wait instruction.
+    Polling,  // WaitEnd, waiting to check the play state.
+    Querying  // WaitEnd, waiting for the play state.
+  };
+
+  Script::Script(DYPlayer *player)
+  {
+    this->player = player;
+    memset(counters, 0, sizeof(counters));
+  }
+
+  uint8_t Script::read(uint16_t i)
+  {
+#ifdef __AVR__
+    return pgm_read_byte(code + i);
+#else
+    return code[i];
+#endif
+  }
+
+  uint16_t Script::read16(uint16_t i)
+  {
+    return (read(i) << 8) | read(i + 1);
+  }
+
+  uint16_t Script::next(uint16_t i)
+  {
+    switch ((script_op_t)read(i))
+    {
+    case ScriptOp::Frame:
+      return i + 2 + read(i + 1);
+    case ScriptOp::Wait:
+    case ScriptOp::Jump:
+      return i + 3;
+    case ScriptOp::Loop:
+      return i + 5;
+    default:
+      return i + 1;
+    }
+  }
+
+  bool Script::isStart(uint16_t target)
+  {
+    if (target < 1 || target >= len)
+      return false;
+    // begin() checked every instruction fits, so the walk stays below len.
+    uint16_t i = 1;
+    while (i < target)
+      i = next(i);
+    return i == target;
+  }
+
+  bool Script::begin(const uint8_t *code, uint16_t len)
+  {
+    state = Done;
+    this->code = code;
+    this->len = len;
+    if (len < 2 || read(0) != DY_SCRIPT_VERSION)
+      return false;
+    // Check it all now, so running it doesn't have to.
+    uint16_t i = 1;
+    while (i < len)
+    {
+      uint16_t size = 1;
+      switch ((script_op_t)read(i))
+      {
+      case ScriptOp::End:
+      case ScriptOp::WaitEnd:
+        break;
+      case ScriptOp::Frame:
+      {
+        if (i + 1 >= len)
+          return false;
+        uint8_t frameLen = read(i + 1);
+        size = 2 + frameLen;
+#ifdef __AVR__
+        if (frameLen > DY_SCRIPT_FRAME_LEN)
+          return false;
+#endif
+        if (frameLen < 4 || i + size > len || read(i + 2) != 0xaa ||
+            read(i + 4) != frameLen - 4)
+          return false;
+        uint8_t sum = 0;
+        for (uint8_t j = 0; j < frameLen - 1; j++)
+          sum += read(i + 2 + j);
+        if (sum != read(i + 2 + frameLen - 1))
+          return false;
+        break;
+      }
+      case ScriptOp::Wait:
+      case ScriptOp::Jump:
+        size = 3;
+        break;
+      case ScriptOp::Loop:
+        size = 5;
+        if (i + size <= len && read(i + 1) >= DY_SCRIPT_LOOPS)
+          return false;
+        break;
+      default:
+        return false;
+      }
+      if (i + size > len)
+        return false;
+      i += size;
+    }
+    // Jumps must land on an instruction, not in the middle of one.
+    for (i = 1; i < len; i = next(i))
+    {
+      script_op_t op = (script_op_t)read(i);
+      if ((op == ScriptOp::Jump && !isStart(read16(i + 1))) ||
+          (op == ScriptOp::Loop && !isStart(read16(i + 3))))
+        return false;
+    }
+    pc = 1;
+    onTime = false;
+    memset(counters, 0, sizeof(counters));
+    state = Running;
+    return true;
+  }
+
+  void Script::stop()
+  {
+    state = Done;
+  }
+
+  bool Script::isRunning()
+  {
+    return state != Done;
+  }
+
+  void Script::sleep(uint16_t ms, uint8_t then)
+  {
+    // Back to back waits count from the end of the previous one, so they
+    // don't drift by how late update() was called.
+    if (!onTime)
+      waitStart = player->timeMs();
+    onTime = false;
+    waitMs = ms;
+    state = then;
+  }
+
+  bool Script::update()
+  {
+    if (state == Sleeping || state == Polling)
+    {
+      if (player->timeMs() - waitStart < waitMs)
+        return true;
+      if (state == Polling)
+      {
+        player->beginQuery(Query::PlayState);
+        state = Querying;
+        return true;
+      }
+      waitStart += waitMs;
+      onTime = true;
+      state = Running;
+    }
+    else if (state == Querying)
+    {
+      uint16_t value;
+      query_state_t query = player->pollQuery(&value);
+      if (query == QueryState::Pending)
+        return true;
+      if (query == QueryState::Fail ||
+          (play_state_t)value != PlayState::Stopped)
+      {
+        sleep(DY_SCRIPT_POLL, Polling);
+        return true;
+      }
+      pc++;
+      state = Running;
+    }
+    if (state != Running)
+      return false;
+
+    bool sent = false;
+    for (uint8_t step = 0; step < DY_SCRIPT_STEPS; step++)
+    {
+      if (pc >= len)
+      {
+        state = Done;
+        return false;
+      }
+      switch ((script_op_t)read(pc))
+      {
+      case ScriptOp::Frame:
+      {
+        if (sent)
+          return true;
+        uint8_t frameLen = read(pc + 1);
+#ifdef __AVR__
+        uint8_t frame[DY_SCRIPT_FRAME_LEN];
+        memcpy_P(frame, code + pc + 2, frameLen);
+#else
+        uint8_t *frame = (uint8_t *)code + pc + 2;
+#endif
+        player->sendFrame(frame, frameLen);
+        pc += 2 + frameLen;
+        sent = true;
+        break;
+      }
+      case ScriptOp::WaitEnd:
+        // Give the module a moment to start playing.
+        onTime = false;
+        sleep(DY_SCRIPT_POLL, Polling);
+        return true;
+      case ScriptOp::Wait:
+        sleep(read16(pc + 1), Sleeping);
+        pc += 3;
+        return true;
+      case ScriptOp::Jump:
+        pc = read16(pc + 1);
+        break;
+      case ScriptOp::Loop:
+      {
+        uint8_t *counter = &counters[read(pc + 1)];
+        uint8_t times = read(pc + 2);
+        if (*counter == 0)
+          *counter = times;
+        if (*counter > 1)
+        {
+          (*counter)--;
+          pc = read16(pc + 3);
+        }
+        else
+        {
+          // Done, start over next time around.
+          *counter = 0;
+          pc += 5;
+        }
+        break;
+      }
+      default:
+        state = Done;
+        return false;
+      }
+    }
+    return true;
+  }
+}
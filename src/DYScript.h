@@ -0,0 +1,146 @@
+/**
+ * Runs sound scripts: sequences like "play 12, wait for the end, volume 20,
+ * play a path, interlude 3, repeat", compiled to bytecode on a computer by
+ * `dyscript.py`. The compiler encodes the frame of every command, so running
+ * a script is sending bytes and keeping time, nothing is parsed or encoded on
+ * the device. `DY::Script::update()` never waits for the module, call it from
+ * `loop()`.
+ *
+ * Bytecode, numbers are big endian like the module's:
+ *
+ * | Instruction | Arguments                   | Does                            |
+ * | :---------- | :-------------------------- | :------------------------------ |
+ * | `End`       |                             | Stop the script.                |
+ * | `Frame`     | length, frame               | Send the frame to the module.   |
+ * | `WaitEnd`   |                             | Wait until it stopped playing.  |
+ * | `Wait`      | milliseconds (2)            | Wait a while.                   |
+ * | `Jump`      | position (2)                | Continue at a position.         |
+ * | `Loop`      | counter, times, position (2) | Jump back, `times` times in all. |
+ *
+ * The bytecode starts with `DY_SCRIPT_VERSION`. On AVR, scripts are read from
+ * flash, declare them with `DY_PROGMEM` (the compiler does).
+ */
+#ifndef DY_SCRIPT_H
+#define DY_SCRIPT_H
+#include <stdint.h>
+#include "DYPlayer.h"
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#define DY_PROGMEM PROGMEM
+#else
+#define DY_PROGMEM
+#endif
+
+#define DY_SCRIPT_VERSION 1
+
+// Loop counters, i.e. how deep `repeat` can be nested.
+#ifndef DY_SCRIPT_LOOPS
+#define DY_SCRIPT_LOOPS 4
+#endif
+
+// Time between play state checks while waiting for the end of a sound.
+#ifndef DY_SCRIPT_POLL
+#define DY_SCRIPT_POLL 100
+#endif
+
+// Instructions run by a single `update()` at most, so it returns in time.
+#ifndef DY_SCRIPT_STEPS
+#define DY_SCRIPT_STEPS 8
+#endif
+
+// Longest frame in a script on AVR, it's copied from flash to the stack.
+#ifndef DY_SCRIPT_FRAME_LEN
+#define DY_SCRIPT_FRAME_LEN 48
+#endif
+
+namespace DY
+{
+  /**
+   * Instructions of the bytecode.
+   */
+  typedef enum class ScriptOp : uint8_t
+  {
+    End,
+    Frame,
+    WaitEnd,
+    Wait,
+    Jump,
+    Loop
+  } script_op_t;
+
+  class Script
+  {
+  public:
+    /**
+     * @param player to run scripts on, should implement `timeMs()`.
+     */
+    Script(DYPlayer *player);
+
+    /**
+     * Check a script and start running it from the top, replacing the
+     * script that was running.
+     * @param code pointer to the bytecode, must stay available.
+     * @param len of code.
+     * @return Started (true), or the bytecode is invalid (false).
+     */
+    bool begin(const uint8_t *code, uint16_t len);
+
+    /**
+     * Run the script until it has to wait, call it as often as you can.
+     * Sends one command at most, and sends queries without waiting for the
+     * response. Use a HAL that doesn't wait in `serialRead()`, e.g.
+     * `DY::Player::setReadBudget()` on Arduino.
+     * @return Running (true), or done (false).
+     */
+    bool update();
+
+    /**
+     * Stop running the script, the sound that is playing keeps playing.
+     */
+    void stop();
+
+    /**
+     * @return Running (true), or done (false).
+     */
+    bool isRunning();
+
+  private:
+    DYPlayer *player;
+    const uint8_t *code = 0;
+    uint16_t len = 0;
+    uint16_t pc = 0;
+    uint8_t state = 0;
+    uint32_t waitStart = 0;
+    uint16_t waitMs = 0;
+    // The wait ended on time, the next one starts from there.
+    bool onTime = false;
+    uint8_t counters[DY_SCRIPT_LOOPS];
+
+    /**
+     * Read a byte of the bytecode, from flash on AVR.
+     */
+    uint8_t read(uint16_t i);
+
+    /**
+     * Read a big endian number of the bytecode.
+     */
+    uint16_t read16(uint16_t i);
+
+    /**
+     * Position of the instruction after the one at `i`, which must be valid.
+     */
+    uint16_t next(uint16_t i);
+
+    /**
+     * @return An instruction starts at `target` (true), or not (false).
+     */
+    bool isStart(uint16_t target);
+
+    /**
+     * Wait for a while before continuing.
+     */
+    void sleep(uint16_t ms, uint8_t then);
+  };
+}
+#endif
@@ -0,0 +1,408 @@
+/**
+ * Discrete event simulation of modules, see DYSimulator.h.
+ */
+#include "DYSimulator.h"
+#if !defined(ARDUINO) && !defined(ESP_PLATFORM)
+#include <string.h>
+
+// Bytes of silence after which the module drops a partial frame.
+#define SIM_FRAME_TIMEOUT 20
+
+namespace DY
+{
+  // A module that keeps up with anything, on a clean line.
+  static const sim_config_t defaults = {
+      1042, 5000, {0, 0, 0, 0, 0, 0}, 0.0};
+
+  void Simulation::at(uint64_t us, SimHandler *handler, uint32_t arg)
+  {
+    event_t event = {us < now ? now : us, seq++, handler, arg};
+    events.push(event);
+  }
+
+  bool Simulation::step(uint64_t until)
+  {
+    if (events.empty() || events.top().at > until)
+    {
+      if (until > now)
+        now = until;
+      return false;
+    }
+    event_t event = events.top();
+    events.pop();
+    now = event.at;
+    handled++;
+    event.handler->fire(event.arg);
+    return true;
+  }
+
+  void Simulation::run(uint64_t until)
+  {
+    while (step(until))
+      ;
+  }
+
+  SimLine::SimLine(Simulation *sim, sim_config_t *config, sim_stats_t *stats,
+                   SimPort *to, uint32_t seed)
+      : random(seed)
+  {
+    this->sim = sim;
+    this->config = config;
+    this->stats = stats;
+    this->to = to;
+  }
+
+  void SimLine::send(uint8_t *bytes, uint8_t len, uint64_t notBefore)
+  {
+    if (len == 0)
+      return;
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    for (uint8_t i = 0; i < len; i++)
+    {
+      uint8_t byte = bytes[i];
+      if (config->errorRate > 0 && chance(random) < config->errorRate)
+      {
+        byte ^= 1 << (random() % 8);
+        stats->errors++;
+      }
+      this->bytes.push_back(byte);
+    }
+    lens.push_back(len);
+    stats->bytes += len;
+    uint64_t start = notBefore > freeAt ? notBefore : freeAt;
+    if (start < sim->now)
+      start = sim->now;
+    freeAt = start + (uint64_t)len * config->byteUs;
+    sim->at(freeAt, this);
+  }
+
+  void SimLine::fire(uint32_t arg)
+  {
+    (void)arg;
+    uint8_t len = lens.front();
+    lens.pop_front();
+    uint8_t buffer[255];
+    for (uint8_t i = 0; i < len; i++)
+    {
+      buffer[i] = bytes.front();
+      bytes.pop_front();
+    }
+    if (to != nullptr)
+      to->receive(buffer, len);
+  }
+
+  // Each line gets its own errors.
+  SimModule::SimModule(Simulation *sim, uint32_t seed)
+      : random(seed), rxLine(sim, &config, &stats, this, random()),
+        txLine(sim, &config, &stats, nullptr, random())
+  {
+    this->sim = sim;
+    config = defaults;
+    memset(&stats, 0, sizeof(stats));
+  }
+
+  SimLine *SimModule::connect(SimPort *player)
+  {
+    txLine.to = player;
+    return &rxLine;
+  }
+
+  play_state_t SimModule::getState()
+  {
+    return state;
+  }
+
+  uint16_t SimModule::getSound()
+  {
+    return sound;
+  }
+
+  uint64_t SimModule::playing()
+  {
+    if (state == PlayState::Playing)
+      return stats.playingUs + sim->now - since;
+    return stats.playingUs;
+  }
+
+  uint8_t SimModule::getVolume()
+  {
+    return volume;
+  }
+
+  void SimModule::powerCycle()
+  {
+    halt(PlayState::Stopped);
+    mode = PlayMode::OneOff;
+    device = Device::Flash;
+    volume = 20;
+    sound = 1;
+    rx.clear();
+  }
+
+  void SimModule::receive(uint8_t *bytes, uint8_t len)
+  {
+    // The bytes arrived over the past len byte times.
+    uint64_t first = sim->now - (uint64_t)len * config.byteUs;
+    if (!rx.empty() &&
+        first > lastByte + (uint64_t)SIM_FRAME_TIMEOUT * config.byteUs)
+      rx.clear();
+    lastByte = sim->now;
+    rx.insert(rx.end(), bytes, bytes + len);
+    while (!rx.empty())
+    {
+      if (rx[0] != 0xaa)
+      {
+        rx.erase(rx.begin());
+        continue;
+      }
+      if (rx.size() < 3 || rx.size() < (size_t)rx[2] + 4)
+        return;
+      uint8_t frameLen = rx[2] + 4;
+      uint8_t sum = 0;
+      for (uint8_t i = 0; i < frameLen - 1; i++)
+        sum += rx[i];
+      if (sum != rx[frameLen - 1])
+      {
+        // Look for the next frame after the start byte.
+        stats.corrupt++;
+        rx.erase(rx.begin());
+        continue;
+      }
+      if (sim->now < busyUntil)
+        stats.dropped++;
+      else
+        handle(&rx[0], frameLen);
+      rx.erase(rx.begin(), rx.begin() + frameLen);
+    }
+  }
+
+  void SimModule::handle(uint8_t *frame, uint8_t len)
+  {
+    stats.frames++;
+    uint8_t command = frame[1];
+    uint16_t number = len >= 6 ? (frame[3] << 8) | frame[4] : 0;
+    uint16_t count = tracks.size();
+    gap_t gap = Gap::Control;
+    switch (command)
+    {
+    case 0x01:
+      respond(command, (uint8_t)state, 5);
+      gap = Gap::Query;
+      break;
+    case 0x02:
+      if (state == PlayState::Paused)
+        start(sound, remaining);
+      else if (sound <= count)
+        start(sound, tracks[sound - 1] * 1000ULL);
+      break;
+    case 0x03:
+      if (state == PlayState::Playing)
+      {
+        remaining = endAt - sim->now;
+        halt(PlayState::Paused);
+      }
+      break;
+    case 0x04:
+      halt(PlayState::Stopped);
+      break;
+    case 0x05:
+    case 0x06:
+      if (count > 0)
+      {
+        sound = command == 0x06 ? sound % count + 1
+                                : (sound + count - 2) % count + 1;
+        start(sound, tracks[sound - 1] * 1000ULL);
+      }
+      break;
+    case 0x07:
+      gap = Gap::Play;
+      if (number >= 1 && number <= count)
+        start(number, tracks[number - 1] * 1000ULL);
+      break;
+    case 0x08:
+    case 0x17:
+      gap = Gap::Path;
+      break;
+    case 0x0a:
+      respond(command, (uint8_t)device, 5);
+      gap = Gap::Query;
+      break;
+    case 0x0b:
+      gap = Gap::Device;
+      if (frame[3] <= (uint8_t)Device::Flash)
+        device = (device_t)frame[3];
+      break;
+    case 0x0c:
+    case 0x12:
+      respond(command, count, 6);
+      gap = Gap::Query;
+      break;
+    case 0x0d:
+      respond(command, sound, 6);
+      gap = Gap::Query;
+      break;
+    case 0x11:
+      respond(command, count > 0 ? 1 : 0, 6);
+      gap = Gap::Query;
+      break;
+    case 0x13:
+      gap = Gap::Setting;
+      volume = frame[3];
+      break;
+    case 0x18:
+      gap = Gap::Setting;
+      mode = (play_mode_t)frame[3];
+      break;
+    case 0x19:
+    case 0x1a:
+      gap = Gap::Setting;
+      break;
+    case 0x16:
+    case 0x1b:
+      gap = Gap::Play;
+      break;
+    case 0x1f:
+      gap = Gap::Play;
+      if (number >= 1 && number <= count)
+      {
+        sound = number;
+        halt(PlayState::Stopped);
+      }
+      break;
+    }
+    busyUntil = sim->now + config.busyUs[(uint8_t)gap];
+  }
+
+  void SimModule::respond(uint8_t command, uint16_t value, uint8_t len)
+  {
+    uint8_t response[6] = {0xaa, command, (uint8_t)(len - 4), 0, 0, 0};
+    if (len == 5)
+    {
+      response[3] = value;
+    }
+    else
+    {
+      response[3] = value >> 8;
+      response[4] = value & 0xff;
+    }
+    for (uint8_t i = 0; i < len - 1; i++)
+      response[len - 1] += response[i];
+    txLine.send(response, len, sim->now + config.responseUs);
+  }
+
+  void SimModule::start(uint16_t number, uint64_t duration)
+  {
+    halt(PlayState::Playing);
+    sound = number;
+    since = sim->now;
+    endAt = sim->now + duration;
+    stats.plays++;
+    sim->at(endAt, this, generation);
+  }
+
+  void SimModule::halt(play_state_t state)
+  {
+    if (this->state == PlayState::Playing)
+      stats.playingUs += sim->now - since;
+    this->state = state;
+    generation++;
+  }
+
+  void SimModule::fire(uint32_t arg)
+  {
+    // A track ended, unless another sound started since.
+    if (arg != generation || state != PlayState::Playing)
+      return;
+    uint16_t count = tracks.size();
+    uint16_t next = 0;
+    switch (mode)
+    {
+    case PlayMode::RepeatOne:
+      next = sound;
+      break;
+    case PlayMode::Repeat:
+    case PlayMode::RepeatDir:
+      next = sound % count + 1;
+      break;
+    case PlayMode::Sequence:
+    case PlayMode::SequenceDir:
+      next = sound < count ? sound + 1 : 0;
+      break;
+    case PlayMode::Random:
+    case PlayMode::RandomDir:
+      next = random() % count + 1;
+      break;
+    default:
+      break;
+    }
+    if (next == 0)
+      halt(PlayState::Stopped);
+    else
+      start(next, tracks[next - 1] * 1000ULL);
+  }
+
+  SimPlayer::SimPlayer(Simulation *sim, SimModule *module)
+  {
+    this->sim = sim;
+    this->module = module;
+    tx = module->connect(this);
+  }
+
+  SimPlayer::~SimPlayer()
+  {
+    module->connect(nullptr);
+  }
+
+  void SimPlayer::serialWrite(uint8_t *buffer, uint8_t len)
+  {
+    tx->send(buffer, len, sim->now);
+  }
+
+  void SimPlayer::receive(uint8_t *bytes, uint8_t len)
+  {
+    rx.insert(rx.end(), bytes, bytes + len);
+  }
+
+  bool SimPlayer::serialRead(uint8_t *buffer, uint8_t len)
+  {
+    uint64_t deadline = sim->now + readTimeout * 1000ULL;
+    while (true)
+    {
+      // Responses start with 0xaa, skip the rest of a late response.
+      size_t skip = 0;
+      while (skip < rx.size() && rx[skip] != 0xaa)
+        skip++;
+      rx.erase(rx.begin(), rx.begin() + skip);
+      if (rx.size() >= len)
+      {
+        memcpy(buffer, &rx[0], len);
+        rx.erase(rx.begin(), rx.begin() + len);
+        return true;
+      }
+      if (!sim->step(deadline))
+        return false;
+    }
+  }
+
+  uint32_t SimPlayer::timeMs()
+  {
+    return sim->now / 1000;
+  }
+
+  void SimPlayer::delayMs(uint16_t ms)
+  {
+    sim->run(sim->now + ms * 1000ULL);
+  }
+
+  void SimPlayer::flushRx()
+  {
+    rx.clear();
+  }
+
+  void SimPlayer::setReadTimeout(uint16_t ms)
+  {
+    readTimeout = ms;
+    rx.clear();
+  }
+}
+#endif
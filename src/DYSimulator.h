@@ -0,0 +1,312 @@
+/**
+ * Discrete event simulation of modules, for builds on a computer. Time is
+ * virtual, it jumps from one event to the next, so hours of playing on
+ * thousands of modules take seconds. Use it to try polling, queueing and
+ * playlist strategies before deploying them, e.g.:
+ *
+ * ```cpp
+ * DY::Simulation sim;
+ * DY::SimModule module(&sim);
+ * module.tracks = {180000, 240000}; // Durations of 00001 and 00002 in ms.
+ * DY::SimPlayer player(&sim, &module);
+ * player.playSpecified(1);
+ * player.delayMs(10000); // Returns right away, 10 virtual seconds later.
+ * ```
+ *
+ * The model: bytes take `byteUs` each on the line, with a chance of a bit
+ * error per byte. The module answers queries after `responseUs`, drops frames
+ * that arrive within `busyUs` after the previous command (see `DY::Gap`) and
+ * plays sounds for as long as their track lasts, then acts on its cycle mode.
+ *
+ * A simulation is single threaded, like the program it runs, run separate
+ * simulations on separate threads to use more cores.
+ */
+#ifndef DY_SIMULATOR_H
+#define DY_SIMULATOR_H
+#if !defined(ARDUINO) && !defined(ESP_PLATFORM)
+#include <deque>
+#include <queue>
+#include <random>
+#include <stdint.h>
+#include <vector>
+#include "DYPlayer.h"
+
+namespace DY
+{
+  /**
+   * Something that happens at a moment in virtual time, see
+   * `DY::Simulation::at()`.
+   */
+  class SimHandler
+  {
+  public:
+    virtual ~SimHandler() {}
+    /**
+     * @param arg passed to `DY::Simulation::at()`.
+     */
+    virtual void fire(uint32_t arg) = 0;
+  };
+
+  class Simulation
+  {
+  public:
+    /**
+     * Virtual time in microseconds.
+     */
+    uint64_t now = 0;
+
+    /**
+     * Events handled so far.
+     */
+    uint64_t handled = 0;
+
+    /**
+     * Schedule an event, events at the same time are handled in the order
+     * they were scheduled.
+     * @param us Virtual time in microseconds, not before `now`.
+     * @param handler to call.
+     * @param arg to pass to the handler.
+     */
+    void at(uint64_t us, SimHandler *handler, uint32_t arg = 0);
+
+    /**
+     * Handle the next event, if it's not later than `until`.
+     * @param until Virtual time in microseconds.
+     * @return An event was handled (true), or there is none until then and
+     *         `now` is `until` (false).
+     */
+    bool step(uint64_t until);
+
+    /**
+     * Handle all events until a moment in virtual time.
+     * @param until Virtual time in microseconds.
+     */
+    void run(uint64_t until);
+
+  private:
+    typedef struct
+    {
+      uint64_t at;
+      uint64_t seq;
+      SimHandler *handler;
+      uint32_t arg;
+    } event_t;
+    struct Later
+    {
+      bool operator()(const event_t &a, const event_t &b) const
+      {
+        return a.at != b.at ? a.at > b.at : a.seq > b.seq;
+      }
+    };
+    std::priority_queue<event_t, std::vector<event_t>, Later> events;
+    uint64_t seq = 0;
+  };
+
+  /**
+   * Receiving end of a simulated UART line.
+   */
+  class SimPort
+  {
+  public:
+    virtual ~SimPort() {}
+    virtual void receive(uint8_t *bytes, uint8_t len) = 0;
+  };
+
+  /**
+   * Model of the UART connection and the module, the defaults are those of
+   * a module at 9600 baud on a short, clean line.
+   */
+  typedef struct
+  {
+    uint32_t byteUs;     // Time on the line per byte (10 bits at 9600 baud).
+    uint32_t responseUs; // Time from a query to the start of the response.
+    uint32_t busyUs[6];  // Time frames are dropped after a command, by gap_t.
+    double errorRate;    // Chance that a byte on the line gets a bit error.
+  } sim_config_t;
+
+  /**
+   * Counters kept by `DY::SimModule`.
+   */
+  typedef struct
+  {
+    uint32_t frames;    // Frames received and handled.
+    uint32_t dropped;   // Frames dropped because the module was busy.
+    uint32_t corrupt;   // Frames dropped because of a bad CRC.
+    uint32_t errors;    // Bytes that got a bit error, both directions.
+    uint32_t bytes;     // Bytes on the line, both directions.
+    uint32_t plays;     // Sounds started.
+    uint64_t playingUs; // Time spent playing, see `DY::SimModule::playing()`.
+  } sim_stats_t;
+
+  /**
+   * One direction of a UART connection, delivers bytes in order after
+   * their time on the line.
+   */
+  class SimLine : public SimHandler
+  {
+  public:
+    /**
+     * Port the bytes are delivered to, they're lost if there is none.
+     */
+    SimPort *to;
+
+    /**
+     * @param sim to schedule deliveries in.
+     * @param config of the line, kept by reference.
+     * @param stats to count bytes and errors in.
+     * @param to port to deliver to.
+     * @param seed of the bit errors.
+     */
+    SimLine(Simulation *sim, sim_config_t *config, sim_stats_t *stats,
+            SimPort *to, uint32_t seed);
+
+    /**
+     * Put bytes on the line, after the bytes already on it.
+     * @param bytes to send.
+     * @param len of bytes.
+     * @param notBefore Virtual time to start sending, if the line is free.
+     */
+    void send(uint8_t *bytes, uint8_t len, uint64_t notBefore);
+
+    void fire(uint32_t arg);
+
+  private:
+    Simulation *sim;
+    sim_config_t *config;
+    sim_stats_t *stats;
+    std::mt19937 random;
+    uint64_t freeAt = 0;
+    // Bytes in flight and the length of each write, in order.
+    std::deque<uint8_t> bytes;
+    std::deque<uint8_t> lens;
+  };
+
+  class SimModule : public SimPort, public SimHandler
+  {
+  public:
+    sim_config_t config;
+    sim_stats_t stats;
+
+    /**
+     * Durations of the sound files in milliseconds, the first is `00001`.
+     */
+    std::vector<uint32_t> tracks;
+
+    /**
+     * @param sim to run in.
+     * @param seed of the line errors and random play.
+     */
+    SimModule(Simulation *sim, uint32_t seed = 1);
+
+    /**
+     * Connect a player, replacing the previous one, done by `DY::SimPlayer`.
+     * @param player port to send responses to, `nullptr` to disconnect.
+     * @return Line from the player to the module.
+     */
+    SimLine *connect(SimPort *player);
+
+    /**
+     * @return Play state, as `DY::DYPlayer::checkPlayState()` would get it.
+     */
+    play_state_t getState();
+
+    /**
+     * @return Sound file that is playing or selected.
+     */
+    uint16_t getSound();
+
+    /**
+     * @return Time spent playing, including the sound playing now.
+     */
+    uint64_t playing();
+
+    /**
+     * @return Volume, as last set.
+     */
+    uint8_t getVolume();
+
+    /**
+     * Power cycle the module, e.g. a brown-out: it stops playing and loses
+     * its settings.
+     */
+    void powerCycle();
+
+    void receive(uint8_t *bytes, uint8_t len);
+    void fire(uint32_t arg);
+
+  private:
+    Simulation *sim;
+    std::mt19937 random;
+    SimLine rxLine;
+    SimLine txLine;
+    play_state_t state = PlayState::Stopped;
+    play_mode_t mode = PlayMode::OneOff;
+    device_t device = Device::Flash;
+    uint8_t volume = 20;
+    uint16_t sound = 1;
+    // Track end events of earlier sounds are ignored.
+    uint32_t generation = 0;
+    uint64_t since = 0;
+    uint64_t endAt = 0;
+    uint64_t remaining = 0;
+    uint64_t busyUntil = 0;
+    uint64_t lastByte = 0;
+    std::vector<uint8_t> rx;
+
+    void handle(uint8_t *frame, uint8_t len);
+    void respond(uint8_t command, uint16_t value, uint8_t len);
+    void start(uint16_t number, uint64_t duration);
+    void halt(play_state_t state);
+  };
+
+  /**
+   * HAL for a simulated module, time only passes while it waits.
+   */
+  class SimPlayer : public DYPlayer, public SimPort
+  {
+  public:
+    Simulation *sim;
+    SimModule *module;
+
+    /**
+     * Connect to a module, replaces the module's previous player.
+     * @param sim to run in.
+     * @param module to connect to.
+     */
+    SimPlayer(Simulation *sim, SimModule *module);
+    ~SimPlayer();
+
+    void serialWrite(uint8_t *buffer, uint8_t len);
+    /**
+     * Runs the simulation until the response arrived or the read timeout
+     * passed.
+     */
+    bool serialRead(uint8_t *buffer, uint8_t len);
+    uint32_t timeMs();
+    /**
+     * Runs the simulation for a while.
+     */
+    void delayMs(uint16_t ms);
+
+    /**
+     * Discard what was received of a response, at this simulated moment.
+     */
+    void flushRx();
+    void receive(uint8_t *bytes, uint8_t len);
+
+    /**
+     * Set how long `serialRead()` waits for a response, in virtual time.
+     * With `0` it never waits, use `beginQuery()` and `pollQuery()` to get
+     * responses.
+     * @param ms Milliseconds, default `1000`.
+     */
+    void setReadTimeout(uint16_t ms);
+
+  private:
+    uint16_t readTimeout = 1000;
+    SimLine *tx;
+    std::vector<uint8_t> rx;
+  };
+}
+#endif
+#endif
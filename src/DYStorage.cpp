@@ -0,0 +1,80 @@
+/*
+  Snapshots kept in storage, and storage for builds on a computer, which keeps
+  the data in a file.
+*/
+#include <string.h>
+#include "DYStorage.h"
+#if !defined(ARDUINO) && !defined(ESP_PLATFORM)
+#include <stdio.h>
+#endif
+
+namespace DY
+{
+  namespace detail
+  {
+    // Sum of the bytes before the CRC, it may be followed by padding.
+    static uint8_t snapshotChecksum(uint8_t *snapshot, uint16_t crc)
+    {
+      uint8_t sum = 0;
+      for (uint16_t i = 0; i < crc; i++)
+      {
+        sum = sum + snapshot[i];
+      }
+      return sum;
+    }
+
+    void snapshotReset(uint8_t *snapshot, uint16_t len, uint8_t magic,
+                       uint8_t version)
+    {
+      memset(snapshot, 0, len);
+      snapshot[0] = magic;
+      snapshot[1] = version;
+    }
+
+    bool snapshotLoad(Storage *storage, uint8_t *snapshot, uint16_t len,
+                      uint16_t crc, uint8_t magic, uint8_t version)
+    {
+      if (!storage->read(snapshot, len) || snapshot[0] != magic ||
+          snapshot[1] != version ||
+          snapshot[crc] != snapshotChecksum(snapshot, crc))
+      {
+        snapshotReset(snapshot, len, magic, version);
+        return false;
+      }
+      return true;
+    }
+
+    bool snapshotSave(Storage *storage, uint8_t *snapshot, uint16_t len,
+                      uint16_t crc)
+    {
+      snapshot[crc] = snapshotChecksum(snapshot, crc);
+      return storage->write(snapshot, len);
+    }
+  }
+
+#if !defined(ARDUINO) && !defined(ESP_PLATFORM)
+  FileStorage::FileStorage(const char *path)
+  {
+    this->path = path;
+  }
+  bool FileStorage::read(uint8_t *buffer, uint16_t len)
+  {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+      return false;
+    size_t length = fread(buffer, 1, len, file);
+    // Anything trailing means it was written with a different length.
+    bool trailing = fgetc(file) != EOF;
+    fclose(file);
+    return length == len && !trailing;
+  }
+  bool FileStorage::write(uint8_t *buffer, uint16_t len)
+  {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL)
+      return false;
+    size_t length = fwrite(buffer, 1, len, file);
+    return fclose(file) == 0 && length == len;
+  }
+#endif
+}
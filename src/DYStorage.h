@@ -0,0 +1,102 @@
+/**
+ * Persistent storage for data the library keeps across power cycles, e.g. the
+ * content index. The HALs provide an implementation for their platform:
+ * `DY::EepromStorage` on Arduino, `DY::NvsStorage` on ESP-IDF and
+ * `DY::FileStorage` for builds on a computer.
+ */
+#ifndef DY_STORAGE_H
+#define DY_STORAGE_H
+#include <stdint.h>
+
+namespace DY
+{
+  class Storage
+  {
+  public:
+    /**
+     * Virtual method that should implement reading a previously written
+     * buffer from persistent storage.
+     * @param buffer pointer to keep the stored data.
+     * @param len of buffer, should be the same as when it was written.
+     * @return Successful read (true), failure or nothing stored (false).
+     */
+    virtual bool read(uint8_t *buffer, uint16_t len) = 0;
+
+    /**
+     * Virtual method that should implement writing a buffer to persistent
+     * storage, replacing whatever was written before.
+     * @param buffer pointer to the data to store.
+     * @param len of buffer.
+     * @return Successful write (true), failure (false).
+     */
+    virtual bool write(uint8_t *buffer, uint16_t len) = 0;
+  };
+
+  namespace detail
+  {
+    // Used by `DY::Snapshot`, on the snapshot as bytes, `crc` is the offset
+    // of the CRC.
+    void snapshotReset(uint8_t *snapshot, uint16_t len, uint8_t magic,
+                       uint8_t version);
+    bool snapshotLoad(Storage *storage, uint8_t *snapshot, uint16_t len,
+                      uint16_t crc, uint8_t magic, uint8_t version);
+    bool snapshotSave(Storage *storage, uint8_t *snapshot, uint16_t len,
+                      uint16_t crc);
+  }
+
+  /**
+   * Data as it goes into storage: a magic byte to tell it apart from other
+   * data, a version to tell it apart from an older layout, the data and a CRC,
+   * the sum of all bytes before it.
+   */
+  template <typename T, uint8_t MAGIC, uint8_t VERSION>
+  struct Snapshot
+  {
+    uint8_t magic;
+    uint8_t version;
+    T data;
+    uint8_t crc;
+
+    /**
+     * Zero the data, including the padding, so it doesn't change the CRC.
+     */
+    void reset()
+    {
+      detail::snapshotReset((uint8_t *)this, sizeof(*this), MAGIC, VERSION);
+    }
+
+    /**
+     * Read the snapshot from storage, reset it on failure.
+     * @param storage to read from.
+     * @return Successful load (true), failure or invalid data (false).
+     */
+    bool load(Storage *storage)
+    {
+      return detail::snapshotLoad(storage, (uint8_t *)this, sizeof(*this),
+                                  &crc - (uint8_t *)this, MAGIC, VERSION);
+    }
+
+    /**
+     * Write the snapshot to storage, with its CRC.
+     * @param storage to write to.
+     * @return Successful save (true), failure (false).
+     */
+    bool save(Storage *storage)
+    {
+      return detail::snapshotSave(storage, (uint8_t *)this, sizeof(*this),
+                                  &crc - (uint8_t *)this);
+    }
+  };
+
+#if !defined(ARDUINO) && !defined(ESP_PLATFORM)
+  class FileStorage : public Storage
+  {
+  public:
+    const char *path;
+    FileStorage(const char *path);
+    bool read(uint8_t *buffer, uint16_t len);
+    bool write(uint8_t *buffer, uint16_t len);
+  };
+#endif
+}
+#endif
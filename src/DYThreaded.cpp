@@ -0,0 +1,257 @@
+/**
+ * Thread-safe player for builds on a computer, see DYThreaded.h.
+ */
+#include "DYThreaded.h"
+#if __cplusplus >= 202002L && !defined(ARDUINO) && !defined(ESP_PLATFORM)
+
+namespace DY
+{
+  JobQueue::JobQueue() : head(&stub), tail(&stub) {}
+
+  void JobQueue::push(Job *job)
+  {
+    job->next.store(nullptr, std::memory_order_relaxed);
+    Job *previous = head.exchange(job, std::memory_order_acq_rel);
+    // Between the exchange and this store the consumer sees a gap and
+    // treats the queue as empty until it's linked.
+    previous->next.store(job, std::memory_order_release);
+  }
+
+  Job *JobQueue::pop()
+  {
+    Job *first = tail;
+    Job *next = first->next.load(std::memory_order_acquire);
+    if (first == &stub)
+    {
+      if (next == nullptr)
+        return nullptr;
+      tail = next;
+      first = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr)
+    {
+      tail = next;
+      return first;
+    }
+    // The last job, it can only be taken if no push is in progress.
+    if (first != head.load(std::memory_order_acquire))
+      return nullptr;
+    push(&stub);
+    next = first->next.load(std::memory_order_acquire);
+    if (next != nullptr)
+    {
+      tail = next;
+      return first;
+    }
+    return nullptr;
+  }
+
+  ThreadedPlayer::ThreadedPlayer(DYPlayer *player)
+      : player(player), thread(&ThreadedPlayer::loop, this) {}
+
+  ThreadedPlayer::~ThreadedPlayer()
+  {
+    running.store(false, std::memory_order_release);
+    signal.fetch_add(1, std::memory_order_release);
+    signal.notify_one();
+    thread.join();
+  }
+
+  void ThreadedPlayer::enqueue(Job *job)
+  {
+    jobs.push(job);
+    signal.fetch_add(1, std::memory_order_release);
+    signal.notify_one();
+  }
+
+  void ThreadedPlayer::loop()
+  {
+    while (true)
+    {
+      // Read the signal before looking for jobs, so a job pushed meanwhile
+      // changes it and the wait below returns right away.
+      uint32_t seen = signal.load(std::memory_order_acquire);
+      Job *job;
+      while ((job = jobs.pop()) != nullptr)
+      {
+        job->run(player);
+        delete job;
+      }
+      // Callers are gone by the time the destructor runs, so every push
+      // completed and the queue is drained.
+      if (!running.load(std::memory_order_acquire))
+        return;
+      signal.wait(seen, std::memory_order_acquire);
+    }
+  }
+
+  std::future<play_state_t> ThreadedPlayer::checkPlayState()
+  {
+    return submit([](DYPlayer *p) { return p->checkPlayState(); });
+  }
+
+  std::future<void> ThreadedPlayer::play()
+  {
+    return submit([](DYPlayer *p) { p->play(); });
+  }
+
+  std::future<void> ThreadedPlayer::pause()
+  {
+    return submit([](DYPlayer *p) { p->pause(); });
+  }
+
+  std::future<void> ThreadedPlayer::stop()
+  {
+    return submit([](DYPlayer *p) { p->stop(); });
+  }
+
+  std::future<void> ThreadedPlayer::previous()
+  {
+    return submit([](DYPlayer *p) { p->previous(); });
+  }
+
+  std::future<void> ThreadedPlayer::next()
+  {
+    return submit([](DYPlayer *p) { p->next(); });
+  }
+
+  std::future<void> ThreadedPlayer::playSpecified(uint16_t number)
+  {
+    return submit([number](DYPlayer *p) { p->playSpecified(number); });
+  }
+
+#ifndef DY_NO_PATHS
+  std::future<void> ThreadedPlayer::playSpecifiedDevicePath(device_t device,
+                                                            const char *path)
+  {
+    // Copy the path, the caller's may be gone by the time it's sent.
+    return submit([device, copy = std::string(path)](DYPlayer *p) mutable
+                  { p->playSpecifiedDevicePath(device, &copy[0]); });
+  }
+#endif
+
+  std::future<device_t> ThreadedPlayer::getPlayingDevice()
+  {
+    return submit([](DYPlayer *p) { return p->getPlayingDevice(); });
+  }
+
+  std::future<void> ThreadedPlayer::setPlayingDevice(device_t device)
+  {
+    return submit([device](DYPlayer *p) { p->setPlayingDevice(device); });
+  }
+
+  std::future<uint16_t> ThreadedPlayer::getSoundCount()
+  {
+    return submit([](DYPlayer *p) { return p->getSoundCount(); });
+  }
+
+  std::future<uint16_t> ThreadedPlayer::getPlayingSound()
+  {
+    return submit([](DYPlayer *p) { return p->getPlayingSound(); });
+  }
+
+  std::future<void> ThreadedPlayer::previousDir(playDirSound_t song)
+  {
+    return submit([song](DYPlayer *p) { p->previousDir(song); });
+  }
+
+  std::future<uint16_t> ThreadedPlayer::getFirstInDir()
+  {
+    return submit([](DYPlayer *p) { return p->getFirstInDir(); });
+  }
+
+  std::future<uint16_t> ThreadedPlayer::getSoundCountDir()
+  {
+    return submit([](DYPlayer *p) { return p->getSoundCountDir(); });
+  }
+
+  std::future<void> ThreadedPlayer::setVolume(uint8_t volume)
+  {
+    return submit([volume](DYPlayer *p) { p->setVolume(volume); });
+  }
+
+  std::future<void> ThreadedPlayer::volumeIncrease()
+  {
+    return submit([](DYPlayer *p) { p->volumeIncrease(); });
+  }
+
+  std::future<void> ThreadedPlayer::volumeDecrease()
+  {
+    return submit([](DYPlayer *p) { p->volumeDecrease(); });
+  }
+
+#ifndef DY_NO_INTERLUDE
+  std::future<void> ThreadedPlayer::interludeSpecified(device_t device,
+                                                       uint16_t number)
+  {
+    return submit([device, number](DYPlayer *p)
+                  { p->interludeSpecified(device, number); });
+  }
+
+#ifndef DY_NO_PATHS
+  std::future<void> ThreadedPlayer::interludeSpecifiedDevicePath(
+      device_t device, const char *path)
+  {
+    return submit([device, copy = std::string(path)](DYPlayer *p) mutable
+                  { p->interludeSpecifiedDevicePath(device, &copy[0]); });
+  }
+#endif
+
+  std::future<void> ThreadedPlayer::stopInterlude()
+  {
+    return submit([](DYPlayer *p) { p->stopInterlude(); });
+  }
+#endif
+
+  std::future<void> ThreadedPlayer::setCycleMode(play_mode_t mode)
+  {
+    return submit([mode](DYPlayer *p) { p->setCycleMode(mode); });
+  }
+
+  std::future<void> ThreadedPlayer::setCycleTimes(uint16_t cycles)
+  {
+    return submit([cycles](DYPlayer *p) { p->setCycleTimes(cycles); });
+  }
+
+  std::future<void> ThreadedPlayer::setEq(eq_t eq)
+  {
+    return submit([eq](DYPlayer *p) { p->setEq(eq); });
+  }
+
+  std::future<void> ThreadedPlayer::select(uint16_t number)
+  {
+    return submit([number](DYPlayer *p) { p->select(number); });
+  }
+
+#ifndef DY_NO_COMBINATION_PLAY
+  std::future<void> ThreadedPlayer::combinationPlay(char *sounds[], uint8_t len)
+  {
+    // Copy the names, each is 2 chars.
+    std::vector<char> copy;
+    for (uint8_t i = 0; i < len; i++)
+      copy.insert(copy.end(), sounds[i], sounds[i] + 2);
+    return submit([copy = std::move(copy), len](DYPlayer *p) mutable
+                  {
+                    std::vector<char *> names;
+                    for (uint8_t i = 0; i < len; i++)
+                      names.push_back(&copy[i * 2]);
+                    p->combinationPlay(names.data(), len); });
+  }
+
+  std::future<void> ThreadedPlayer::endCombinationPlay()
+  {
+    return submit([](DYPlayer *p) { p->endCombinationPlay(); });
+  }
+#endif
+
+  std::future<std::pair<bool, uint16_t>> ThreadedPlayer::query(query_t query)
+  {
+    return submit([query](DYPlayer *p)
+                  {
+                    uint16_t value = 0;
+                    bool ok = p->query(query, &value);
+                    return std::make_pair(ok, value); });
+  }
+}
+#endif
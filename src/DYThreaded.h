@@ -0,0 +1,162 @@
+/**
+ * Thread-safe player for builds on a computer. A single I/O thread owns the
+ * player and runs commands one at a time, so a query and its response are
+ * never interleaved with another thread's command. Any thread can call the
+ * methods, they queue the command on a lock-free queue and return a future
+ * right away, so callers never wait for each other's UART round trip.
+ */
+#ifndef DY_THREADED_H
+#define DY_THREADED_H
+#if __cplusplus >= 202002L && !defined(ARDUINO) && !defined(ESP_PLATFORM)
+#include <atomic>
+#include <future>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "DYPlayer.h"
+
+namespace DY
+{
+  /**
+   * A command for the I/O thread.
+   */
+  class Job
+  {
+  public:
+    std::atomic<Job *> next{nullptr};
+    virtual ~Job() {}
+    virtual void run(DYPlayer *) {}
+  };
+
+  /**
+   * Multiple producer, single consumer queue of jobs, producers never wait
+   * for each other (intrusive, after Dmitry Vyukov's MPSC queue).
+   */
+  class JobQueue
+  {
+  public:
+    JobQueue();
+    /**
+     * Add a job, safe to call from any thread.
+     * @param job to add, the consumer deletes it after running it.
+     */
+    void push(Job *job);
+    /**
+     * Take the next job, call from the consumer thread only.
+     * @return The job, or `nullptr` if there is none (yet).
+     */
+    Job *pop();
+
+  private:
+    std::atomic<Job *> head;
+    Job *tail;
+    Job stub;
+  };
+
+  class ThreadedPlayer
+  {
+  public:
+    /**
+     * Start the I/O thread, from now on only the I/O thread may use the
+     * player, configure it before (e.g. gaps).
+     * @param player to own.
+     */
+    ThreadedPlayer(DYPlayer *player);
+
+    /**
+     * Runs the commands that are still queued and stops the I/O thread.
+     */
+    ~ThreadedPlayer();
+
+    /**
+     * Run a function on the I/O thread, with the player.
+     * @param f function taking a `DYPlayer *`.
+     * @return Future for the return value of the function.
+     */
+    template <typename F>
+    auto submit(F f) -> std::future<decltype(f((DYPlayer *)nullptr))>
+    {
+      typedef decltype(f((DYPlayer *)nullptr)) R;
+      FunctionJob<R, F> *job = new FunctionJob<R, F>(std::move(f));
+      std::future<R> future = job->promise.get_future();
+      enqueue(job);
+      return future;
+    }
+
+    std::future<play_state_t> checkPlayState();
+    std::future<void> play();
+    std::future<void> pause();
+    std::future<void> stop();
+    std::future<void> previous();
+    std::future<void> next();
+    std::future<void> playSpecified(uint16_t number);
+#ifndef DY_NO_PATHS
+    std::future<void> playSpecifiedDevicePath(device_t device, const char *path);
+#endif
+    std::future<device_t> getPlayingDevice();
+    std::future<void> setPlayingDevice(device_t device);
+    std::future<uint16_t> getSoundCount();
+    std::future<uint16_t> getPlayingSound();
+    std::future<void> previousDir(playDirSound_t song);
+    std::future<uint16_t> getFirstInDir();
+    std::future<uint16_t> getSoundCountDir();
+    std::future<void> setVolume(uint8_t volume);
+    std::future<void> volumeIncrease();
+    std::future<void> volumeDecrease();
+#ifndef DY_NO_INTERLUDE
+    std::future<void> interludeSpecified(device_t device, uint16_t number);
+#ifndef DY_NO_PATHS
+    std::future<void> interludeSpecifiedDevicePath(device_t device, const char *path);
+#endif
+    std::future<void> stopInterlude();
+#endif
+    std::future<void> setCycleMode(play_mode_t mode);
+    std::future<void> setCycleTimes(uint16_t cycles);
+    std::future<void> setEq(eq_t eq);
+    std::future<void> select(uint16_t number);
+#ifndef DY_NO_COMBINATION_PLAY
+    std::future<void> combinationPlay(char *sounds[], uint8_t len);
+    std::future<void> endCombinationPlay();
+#endif
+    /**
+     * See `DY::DYPlayer::query()`, the future is `false` on failure.
+     */
+    std::future<std::pair<bool, uint16_t>> query(query_t query);
+
+  private:
+    template <typename R, typename F>
+    class FunctionJob : public Job
+    {
+    public:
+      std::promise<R> promise;
+      F f;
+      FunctionJob(F &&f) : f(std::move(f)) {}
+      void run(DYPlayer *player)
+      {
+        if constexpr (std::is_void<R>::value)
+        {
+          f(player);
+          promise.set_value();
+        }
+        else
+        {
+          promise.set_value(f(player));
+        }
+      }
+    };
+
+    DYPlayer *player;
+    JobQueue jobs;
+    // Bumped for every job, the I/O thread sleeps on it when idle.
+    std::atomic<uint32_t> signal{0};
+    std::atomic<bool> running{true};
+    std::thread thread;
+
+    void enqueue(Job *job);
+    void loop();
+  };
+}
+#endif
+#endif
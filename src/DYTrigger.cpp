@@ -0,0 +1,51 @@
+/**
+ * Queue of sounds to play, see DYTrigger.h.
+ */
+#include "DYTrigger.h"
+
+#if (DY_TRIGGER_QUEUE_LEN & (DY_TRIGGER_QUEUE_LEN - 1)) != 0
+#error "DY_TRIGGER_QUEUE_LEN must be a power of 2"
+#endif
+#define TRIGGER_MASK (DY_TRIGGER_QUEUE_LEN - 1)
+
+namespace DY
+{
+  TriggerQueue::TriggerQueue()
+  {
+    head = 0;
+    tail = 0;
+  }
+
+  bool TriggerQueue::push(uint16_t number)
+  {
+    uint8_t next = (head + 1) & TRIGGER_MASK;
+    if (next == tail)
+      return false;
+    // Write the sound before publishing it by moving the head.
+    sounds[head] = number;
+    head = next;
+    return true;
+  }
+
+  bool TriggerQueue::pop(uint16_t *number)
+  {
+    if (tail == head)
+      return false;
+    // The interrupt doesn't touch this slot until the tail moves past it.
+    *number = sounds[tail];
+    tail = (tail + 1) & TRIGGER_MASK;
+    return true;
+  }
+
+  uint8_t TriggerQueue::drain(DYPlayer *player)
+  {
+    uint8_t played = 0;
+    uint16_t number;
+    while (pop(&number))
+    {
+      player->playSpecified(number);
+      played++;
+    }
+    return played;
+  }
+}
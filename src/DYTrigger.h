@@ -0,0 +1,55 @@
+/**
+ * Queue of sounds to play, that can be filled from an interrupt service
+ * routine (e.g. a button on a pin change interrupt) and drained in `loop()`.
+ * The player can't be used from an interrupt, sending takes too long.
+ *
+ * It's safe for one interrupt to push and the main program to drain, the
+ * indices are single bytes, which are read and written atomically, even on
+ * AVR. No memory is allocated, it uses `2 * DY_TRIGGER_QUEUE_LEN + 2` bytes.
+ */
+#ifndef DY_TRIGGER_H
+#define DY_TRIGGER_H
+#include <stdint.h>
+#include "DYPlayer.h"
+
+// Must be a power of 2, one slot is kept free to tell full from empty.
+#ifndef DY_TRIGGER_QUEUE_LEN
+#define DY_TRIGGER_QUEUE_LEN 8
+#endif
+
+namespace DY
+{
+  class TriggerQueue
+  {
+  public:
+    TriggerQueue();
+
+    /**
+     * Add a sound to play, safe to call from an interrupt.
+     * @param number of the file, e.g. `1` for `00001.mp3`.
+     * @return Added (true), or the queue is full (false).
+     */
+    bool push(uint16_t number);
+
+    /**
+     * Take the next sound to play from the queue, call from the main program
+     * only.
+     * @param number pointer to keep the number of the file in.
+     * @return Taken (true), or the queue is empty (false).
+     */
+    bool pop(uint16_t *number);
+
+    /**
+     * Play each sound in the queue, call from `loop()`.
+     * @param player to play the sounds with.
+     * @return number of sounds played.
+     */
+    uint8_t drain(DYPlayer *player);
+
+  private:
+    volatile uint16_t sounds[DY_TRIGGER_QUEUE_LEN];
+    volatile uint8_t head;
+    volatile uint8_t tail;
+  };
+}
+#endif